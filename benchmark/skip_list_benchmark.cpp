@@ -0,0 +1,584 @@
+// replays a trace of operations against a Skip_list and reports the latency
+// percentiles of every kind of operation, the allocations they caused and,
+// where the kernel allows it, hardware counters.
+//
+// trace format, one operation per line, # starts a comment:
+//
+//     i <key>          insert (key, key)
+//     e <key>          erase
+//     f <key>          find
+//     s <key> <count>  scan count elements from lower_bound(key)
+//
+// without --trace a random trace is generated, --record writes it to a file
+// so a run can be repeated exactly.
+
+#include "skip_list.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> // __rdtsc()
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// allocation counters. operator new is replaced below, the nodes of the
+// list come through Counting_storage
+std::atomic<std::uint64_t> allocations{0};
+std::atomic<std::uint64_t> allocated_bytes{0};
+std::atomic<std::uint64_t> deallocations{0};
+
+struct Counting_storage {
+    static constexpr std::size_t sequence_length =
+        skip_list::Heap_storage::sequence_length;
+
+    static void* allocate(std::size_t size, std::size_t alignment)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+        return skip_list::Heap_storage::allocate(size, alignment);
+    }
+
+    static void allocate_sequence(std::size_t count, const std::size_t* sizes,
+                                  std::size_t alignment, void** out)
+    {
+        for (auto i = std::size_t{}; i < count; ++i) {
+            allocations.fetch_add(1, std::memory_order_relaxed);
+            allocated_bytes.fetch_add(sizes[i], std::memory_order_relaxed);
+        }
+        skip_list::Heap_storage::allocate_sequence(count, sizes, alignment,
+                                                   out);
+    }
+
+    static void deallocate(void* p, std::size_t size,
+                           std::size_t alignment) noexcept
+    {
+        deallocations.fetch_add(1, std::memory_order_relaxed);
+        skip_list::Heap_storage::deallocate(p, size, alignment);
+    }
+};
+
+using List = skip_list::Skip_list<std::uint64_t, std::uint64_t, 0, false,
+                                  Counting_storage>;
+
+enum class Kind { insert, erase, find, scan };
+constexpr auto kind_count = std::size_t{4};
+constexpr std::array<const char*, kind_count> kind_names{"insert", "erase",
+                                                         "find", "scan"};
+
+struct Operation {
+    Kind kind;
+    std::uint64_t key;
+    std::uint64_t count; // elements of a scan
+};
+
+struct Options {
+    std::string trace;
+    std::string record;
+    std::size_t operations = 1000000;
+    std::uint64_t keys = 1000000;
+    std::size_t preload = 500000;
+    std::array<unsigned, kind_count> mix{40, 40, 15, 5}; // percent
+    std::uint64_t scan_length = 100;
+    std::uint64_t seed = 42;
+};
+
+// ticks of the time stamp counter where there is one, nanoseconds otherwise.
+// ticks_per_ns converts them after the run
+std::uint64_t now() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_lfence(); // no earlier instruction may still be running
+    const auto ticks = __rdtsc();
+    _mm_lfence();
+    return ticks;
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#endif
+}
+
+double ticks_per_ns()
+{
+    const auto start_time = std::chrono::steady_clock::now();
+    const auto start_ticks = now();
+
+    while (std::chrono::steady_clock::now() - start_time <
+           std::chrono::milliseconds{50}) {
+    }
+
+    const auto ticks = now() - start_ticks;
+    const auto elapsed = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start_time);
+    return static_cast<double>(ticks) / elapsed.count();
+}
+
+// a group of hardware counters read together. every counter the kernel or
+// the machine refuses, e.g. in a container, is left out
+class Hardware_counters {
+public:
+    Hardware_counters()
+    {
+#if defined(__linux__)
+        const std::array<std::pair<std::uint64_t, const char*>, 4> events{{
+            {PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+            {PERF_COUNT_HW_INSTRUCTIONS, "instructions"},
+            {PERF_COUNT_HW_CACHE_MISSES, "cache misses"},
+            {PERF_COUNT_HW_BRANCH_MISSES, "branch misses"},
+        }};
+
+        for (const auto& [config, name] : events) {
+            auto attributes = perf_event_attr{};
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.size = sizeof(attributes);
+            attributes.config = config;
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+
+            const auto fd = static_cast<int>(
+                syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+            if (fd >= 0) {
+                counters.push_back(Counter{fd, name, 0});
+            }
+        }
+#endif
+    }
+
+    ~Hardware_counters()
+    {
+#if defined(__linux__)
+        for (const auto& counter : counters) {
+            close(counter.fd);
+        }
+#endif
+    }
+
+    Hardware_counters(const Hardware_counters&) = delete;
+    Hardware_counters& operator=(const Hardware_counters&) = delete;
+
+    bool available() const noexcept
+    {
+        return !counters.empty();
+    }
+
+    void start()
+    {
+#if defined(__linux__)
+        for (const auto& counter : counters) {
+            ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    void stop()
+    {
+#if defined(__linux__)
+        for (auto& counter : counters) {
+            ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(counter.fd, &counter.value, sizeof(counter.value)) !=
+                sizeof(counter.value)) {
+                counter.value = 0;
+            }
+        }
+#endif
+    }
+
+    void print(std::ostream& os, std::size_t operations) const
+    {
+        for (const auto& counter : counters) {
+            os << "  " << counter.name << ": " << counter.value << " ("
+               << static_cast<double>(counter.value) / operations
+               << " per operation)\n";
+        }
+    }
+
+private:
+    struct Counter {
+        int fd;
+        const char* name;
+        std::uint64_t value;
+    };
+
+    std::vector<Counter> counters;
+};
+
+std::vector<Operation> generate(const Options& options)
+{
+    auto engine = std::mt19937_64{options.seed};
+    auto key =
+        std::uniform_int_distribution<std::uint64_t>{0, options.keys - 1};
+
+    const auto total = options.mix[0] + options.mix[1] + options.mix[2] +
+                       options.mix[3];
+    auto pick = std::uniform_int_distribution<unsigned>{0, total - 1};
+
+    auto trace = std::vector<Operation>{};
+    trace.reserve(options.operations);
+
+    for (auto i = std::size_t{}; i < options.operations; ++i) {
+        auto choice = pick(engine);
+        auto kind = std::size_t{};
+        while (choice >= options.mix[kind]) {
+            choice -= options.mix[kind++];
+        }
+        trace.push_back(Operation{static_cast<Kind>(kind), key(engine),
+                                  options.scan_length});
+    }
+    return trace;
+}
+
+std::vector<Operation> load(const std::string& path)
+{
+    auto file = std::ifstream{path};
+    if (!file) {
+        throw std::runtime_error{"can not open trace " + path};
+    }
+
+    auto trace = std::vector<Operation>{};
+    auto line = std::string{};
+    auto number = std::size_t{};
+
+    while (std::getline(file, line)) {
+        ++number;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        auto fields = std::istringstream{line};
+        auto code = char{};
+        auto operation = Operation{Kind::find, 0, 0};
+        fields >> code >> operation.key;
+
+        switch (code) {
+        case 'i':
+            operation.kind = Kind::insert;
+            break;
+        case 'e':
+            operation.kind = Kind::erase;
+            break;
+        case 'f':
+            operation.kind = Kind::find;
+            break;
+        case 's':
+            operation.kind = Kind::scan;
+            fields >> operation.count;
+            break;
+        default:
+            fields.setstate(std::ios::failbit);
+        }
+
+        if (!fields) {
+            throw std::runtime_error{path + ":" + std::to_string(number) +
+                                     ": can not parse '" + line + "'"};
+        }
+        trace.push_back(operation);
+    }
+    return trace;
+}
+
+void save(const std::string& path, const std::vector<Operation>& trace)
+{
+    auto file = std::ofstream{path};
+    const char codes[] = {'i', 'e', 'f', 's'};
+
+    for (const auto& operation : trace) {
+        file << codes[static_cast<std::size_t>(operation.kind)] << ' '
+             << operation.key;
+        if (operation.kind == Kind::scan) {
+            file << ' ' << operation.count;
+        }
+        file << '\n';
+    }
+}
+
+struct Result {
+    std::vector<std::uint64_t> latencies; // ticks
+    std::uint64_t allocations = 0;
+    std::uint64_t deallocations = 0;
+    std::uint64_t bytes = 0;
+};
+
+std::uint64_t run(List& list, const Operation& operation)
+// the checksum keeps the compiler from dropping lookups and scans
+{
+    switch (operation.kind) {
+    case Kind::insert:
+        list.insert(std::make_pair(operation.key, operation.key));
+        return 0;
+    case Kind::erase:
+        return list.erase(operation.key);
+    case Kind::find:
+        return list.find(operation.key) != list.end();
+    case Kind::scan: {
+        auto sum = std::uint64_t{};
+        auto it = list.lower_bound(operation.key);
+        for (auto i = std::uint64_t{}; i < operation.count && it != list.end();
+             ++i, ++it) {
+            sum += it->second;
+        }
+        return sum;
+    }
+    }
+    return 0;
+}
+
+// the build type CMake passes in, and whether the compiler optimized. the
+// numbers of an unoptimized build say nothing about the list
+void print_build(std::ostream& os)
+{
+#if defined(SKIP_LIST_BUILD_TYPE)
+    const auto build_type = std::string{SKIP_LIST_BUILD_TYPE};
+#else
+    const auto build_type = std::string{};
+#endif
+#if defined(__OPTIMIZE__)
+    const auto optimized = true;
+#else
+    const auto optimized = false;
+#endif
+
+    os << "build type " << (build_type.empty() ? "unknown" : build_type)
+       << (optimized ? ", optimized" : ", NOT optimized, numbers are useless")
+       << "\n";
+}
+
+double percentile(const std::vector<std::uint64_t>& sorted, double p)
+{
+    const auto index = static_cast<std::size_t>(p * (sorted.size() - 1));
+    return static_cast<double>(sorted[index]);
+}
+
+void report(std::ostream& os, std::array<Result, kind_count>& results,
+            double ticks_per_ns)
+{
+    char line[160];
+    std::snprintf(line, sizeof(line),
+                  "%-8s %10s %10s %10s %10s %10s %10s %12s\n",
+                  "op", "count", "mean ns", "p50 ns", "p99 ns", "p99.9 ns",
+                  "max ns", "allocs/op");
+    os << line;
+
+    for (auto kind = std::size_t{}; kind < kind_count; ++kind) {
+        auto& result = results[kind];
+        auto& latencies = result.latencies;
+        if (latencies.empty()) {
+            continue;
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+
+        auto sum = 0.0;
+        for (const auto latency : latencies) {
+            sum += static_cast<double>(latency);
+        }
+
+        const auto count = latencies.size();
+        std::snprintf(
+            line, sizeof(line),
+            "%-8s %10zu %10.1f %10.1f %10.1f %10.1f %10.1f %12.3f\n",
+            kind_names[kind], count, sum / count / ticks_per_ns,
+            percentile(latencies, 0.5) / ticks_per_ns,
+            percentile(latencies, 0.99) / ticks_per_ns,
+            percentile(latencies, 0.999) / ticks_per_ns,
+            static_cast<double>(latencies.back()) / ticks_per_ns,
+            static_cast<double>(result.allocations) / count);
+        os << line;
+    }
+}
+
+Options parse(int argc, char** argv)
+{
+    auto options = Options{};
+
+    const auto value = [&](int& i) -> std::string {
+        if (i + 1 >= argc) {
+            throw std::runtime_error{std::string{argv[i]} + " needs a value"};
+        }
+        return argv[++i];
+    };
+
+    for (auto i = 1; i < argc; ++i) {
+        const auto argument = std::string{argv[i]};
+
+        if (argument == "--trace") {
+            options.trace = value(i);
+        }
+        else if (argument == "--record") {
+            options.record = value(i);
+        }
+        else if (argument == "--operations") {
+            options.operations = std::stoull(value(i));
+        }
+        else if (argument == "--keys") {
+            options.keys = std::stoull(value(i));
+        }
+        else if (argument == "--preload") {
+            options.preload = std::stoull(value(i));
+        }
+        else if (argument == "--scan-length") {
+            options.scan_length = std::stoull(value(i));
+        }
+        else if (argument == "--seed") {
+            options.seed = std::stoull(value(i));
+        }
+        else if (argument == "--mix") { // insert,erase,find,scan in percent
+            auto fields = std::istringstream{value(i)};
+            auto separator = char{};
+            fields >> options.mix[0] >> separator >> options.mix[1] >>
+                separator >> options.mix[2] >> separator >> options.mix[3];
+            if (!fields || options.mix[0] + options.mix[1] + options.mix[2] +
+                                   options.mix[3] ==
+                               0) {
+                throw std::runtime_error{"--mix expects e.g. 40,40,15,5"};
+            }
+        }
+        else {
+            throw std::runtime_error{
+                "usage: benchmark [--trace file] [--record file] "
+                "[--operations n] [--keys n] [--preload n] [--mix i,e,f,s] "
+                "[--scan-length n] [--seed n]"};
+        }
+    }
+
+    if (options.keys == 0) {
+        throw std::runtime_error{"--keys must not be 0"};
+    }
+    return options;
+}
+
+} // namespace
+
+// every allocation of the process outside of the list, e.g. of the trace
+// itself, shows up here. only the difference around an operation counts
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    if (const auto p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+    if (p) {
+        deallocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    operator delete(p);
+}
+
+int main(int argc, char** argv)
+{
+    try {
+        const auto options = parse(argc, argv);
+
+        const auto trace =
+            options.trace.empty() ? generate(options) : load(options.trace);
+        if (!options.record.empty()) {
+            save(options.record, trace);
+        }
+
+        auto list = List{};
+        auto engine = std::mt19937_64{options.seed + 1};
+        auto key = std::uniform_int_distribution<std::uint64_t>{
+            0, options.keys - 1};
+        for (auto i = std::size_t{}; i < options.preload; ++i) {
+            const auto k = key(engine);
+            list.insert(std::make_pair(k, k));
+        }
+
+        auto results = std::array<Result, kind_count>{};
+        for (auto& result : results) {
+            result.latencies.reserve(trace.size());
+        }
+
+        auto counters = Hardware_counters{};
+        auto checksum = std::uint64_t{};
+
+        counters.start();
+        for (const auto& operation : trace) {
+            const auto allocations_before =
+                allocations.load(std::memory_order_relaxed);
+            const auto deallocations_before =
+                deallocations.load(std::memory_order_relaxed);
+            const auto bytes_before =
+                allocated_bytes.load(std::memory_order_relaxed);
+
+            const auto start = now();
+            checksum += run(list, operation);
+            const auto stop = now();
+
+            auto& result = results[static_cast<std::size_t>(operation.kind)];
+            result.latencies.push_back(stop - start);
+            result.allocations +=
+                allocations.load(std::memory_order_relaxed) -
+                allocations_before;
+            result.deallocations +=
+                deallocations.load(std::memory_order_relaxed) -
+                deallocations_before;
+            result.bytes +=
+                allocated_bytes.load(std::memory_order_relaxed) - bytes_before;
+        }
+        counters.stop();
+
+        print_build(std::cout);
+        std::cout << trace.size() << " operations, " << options.preload
+                  << " preloaded, checksum " << checksum << "\n\n";
+        report(std::cout, results, ticks_per_ns());
+
+        std::cout << "\nallocations (count / bytes / frees):\n";
+        for (auto kind = std::size_t{}; kind < kind_count; ++kind) {
+            const auto& result = results[kind];
+            if (!result.latencies.empty()) {
+                std::cout << "  " << kind_names[kind] << ": "
+                          << result.allocations << " / " << result.bytes
+                          << " / " << result.deallocations << '\n';
+            }
+        }
+
+        std::cout << "\nhardware counters over the whole replay:\n";
+        if (counters.available()) {
+            counters.print(std::cout, trace.size());
+        }
+        else {
+            std::cout << "  not available (perf_event_paranoid or no PMU)\n";
+        }
+    }
+    catch (const std::exception& error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+}
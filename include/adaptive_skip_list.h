@@ -0,0 +1,219 @@
+#ifndef ADAPTIVE_SKIP_LIST_H
+#define ADAPTIVE_SKIP_LIST_H
+
+#include "skip_list.h"
+
+#include <algorithm>     // std::sort
+#include <cstdint>       // std::uint32_t
+#include <unordered_map> // access counts of sampled keys
+#include <utility>       // std::pair
+#include <vector>        // ranking of the sampled keys
+
+namespace skip_list {
+
+// Skip list which raises the towers of frequently read keys, so hot keys are
+// found after a few comparisons instead of the O(log n) expected for every
+// key of a plain Skip_list.
+//
+// to keep reads cheap only every sample_period-th successful find is
+// counted. every decay_period samples the keys with at least
+// promote_threshold samples are ranked by their count. rank r gets a tower
+// of top_level - log2(r + 1) levels like in a biased skip list: the hottest
+// key alone on the top level, the next two one level below and so on, so the
+// promoted keys form a balanced search tree of their own instead of crowding
+// the top level. then all counts are halved. keys dropping to 0 are
+// forgotten and, if they were promoted, get a new random height again.
+// each find costs O(1) amortized on top of the lookup and a tower is only
+// rebuilt when the rank of its key changes its height.
+template <typename Key, typename T> class Adaptive_skip_list {
+public:
+    using list_type = Skip_list<Key, T>;
+    using key_type = typename list_type::key_type;
+    using mapped_type = typename list_type::mapped_type;
+    using value_type = typename list_type::value_type;
+    using size_type = typename list_type::size_type;
+    using iterator = typename list_type::iterator;
+    using const_iterator = typename list_type::const_iterator;
+
+    explicit Adaptive_skip_list(std::uint32_t sample_period = 8,
+                                std::uint32_t promote_threshold = 4,
+                                std::uint32_t decay_period = 1024)
+        : sample_period{sample_period}, promote_threshold{promote_threshold},
+          decay_period{decay_period}
+    {
+    }
+
+    iterator begin() noexcept
+    {
+        return list.begin();
+    }
+
+    iterator end() noexcept
+    {
+        return list.end();
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return list.begin();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return list.end();
+    }
+
+    bool empty() const noexcept
+    {
+        return list.empty();
+    }
+
+    size_type size() const noexcept
+    {
+        return list.size();
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        return list.insert(value);
+    }
+
+    size_type erase(const key_type& key)
+    {
+        heat.erase(key);
+        return list.erase(key);
+    }
+
+    void clear() noexcept
+    {
+        heat.clear();
+        list.clear();
+    }
+
+    // counts the access and may rebuild the tower of the key
+    iterator find(const key_type& key);
+
+    // read only lookup, does not adapt
+    const_iterator find(const key_type& key) const
+    {
+        return list.find(key);
+    }
+
+    size_type count(const key_type& key) const
+    {
+        return list.count(key);
+    }
+
+    size_type search_length(const key_type& key) const
+    {
+        return list.search_length(key);
+    }
+
+    const list_type& base() const noexcept
+    {
+        return list;
+    }
+
+private:
+    struct Heat {
+        std::uint32_t samples;
+        bool promoted;
+    };
+
+    iterator sample(iterator position);
+    void decay();
+
+    list_type list;
+    std::unordered_map<key_type, Heat> heat;
+
+    std::uint32_t sample_period;
+    std::uint32_t promote_threshold;
+    std::uint32_t decay_period;
+
+    std::uint32_t finds = 0;
+    std::uint32_t samples = 0;
+};
+
+template <typename Key, typename T>
+typename Adaptive_skip_list<Key, T>::iterator
+Adaptive_skip_list<Key, T>::find(const key_type& key)
+{
+    const auto position = list.find(key);
+
+    if (position == list.end() || ++finds < sample_period) {
+        return position;
+    }
+
+    finds = 0;
+    return sample(position);
+}
+
+template <typename Key, typename T>
+typename Adaptive_skip_list<Key, T>::iterator
+Adaptive_skip_list<Key, T>::sample(iterator position)
+{
+    ++heat[position->first].samples;
+
+    if (++samples >= decay_period) {
+        const auto key = position->first;
+        decay();
+        position = list.find(key); // decay can rebuild this node as well
+    }
+    return position;
+}
+
+template <typename Key, typename T>
+void Adaptive_skip_list<Key, T>::decay()
+// there are at most decay_period entries, so the amortized cost per sample
+// is O(log decay_period) for the ranking
+{
+    samples = 0;
+
+    auto ranking = std::vector<std::pair<std::uint32_t, const key_type*>>{};
+    for (const auto& [key, entry] : heat) {
+        if (entry.samples >= promote_threshold) {
+            ranking.emplace_back(entry.samples, &key);
+        }
+    }
+    std::sort(std::begin(ranking), std::end(ranking),
+              [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    const auto top = list.top_level();
+
+    for (auto rank = size_type{}; rank < ranking.size(); ++rank) {
+        auto depth = size_type{};
+        for (auto r = rank + 1; r > 1; r /= 2) {
+            ++depth;
+        }
+        const auto levels = depth < top ? top - depth : size_type{1};
+
+        const auto& key = *ranking[rank].second;
+        auto& entry = heat[key];
+        const auto position = list.find(key);
+
+        // a cold key keeps its random height if that is already higher
+        if (entry.promoted ? list.level(position) != levels
+                           : list.level(position) < levels) {
+            list.set_level(position, levels);
+            entry.promoted = true;
+        }
+    }
+
+    for (auto it = heat.begin(); it != heat.end();) {
+        auto& entry = it->second;
+        entry.samples /= 2;
+
+        if (entry.samples == 0) {
+            if (entry.promoted) {
+                list.reset_level(list.find(it->first));
+            }
+            it = heat.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+} // namespace skip_list
+#endif
@@ -0,0 +1,497 @@
+#ifndef AUGMENTED_SKIP_LIST_H
+#define AUGMENTED_SKIP_LIST_H
+
+#include "skip_list_detail.h"
+
+#include <cassert>
+#include <cstdlib>     // aligned_alloc() and free()
+#include <iterator>    // std::forward_iterator_tag
+#include <limits>      // identity of Minimum and Maximum
+#include <new>         // placement new
+#include <type_traits> // std::is_nothrow_copy_constructible_v
+#include <utility>     // std::pair
+#include <vector>      // for head implementation
+
+namespace skip_list {
+
+// monoids for Augmented_skip_list. a monoid provides identity() and an
+// associative operator() combining two values
+template <typename T> struct Plus {
+    T identity() const
+    {
+        return T{};
+    }
+    T operator()(const T& a, const T& b) const
+    {
+        return a + b;
+    }
+};
+
+template <typename T> struct Minimum {
+    T identity() const
+    {
+        return std::numeric_limits<T>::max();
+    }
+    T operator()(const T& a, const T& b) const
+    {
+        return b < a ? b : a;
+    }
+};
+
+template <typename T> struct Maximum {
+    T identity() const
+    {
+        return std::numeric_limits<T>::lowest();
+    }
+    T operator()(const T& a, const T& b) const
+    {
+        return a < b ? b : a;
+    }
+};
+
+// Skip list where every link stores the combination of the mapped values of
+// the nodes it spans: the link at level i of node x covers x itself and all
+// nodes up to, but not including, the next node of level i. insert and erase
+// recompute the links on the search path, so aggregate(lo, hi) can answer a
+// range query in O(log n) by taking the highest links which fit in the range.
+//
+// the elements can only be read through iterators, a value changed behind
+// the back of the list would make the stored aggregates wrong. use insert to
+// change a value.
+template <typename Key, typename T, typename Monoid = Plus<T>>
+class Augmented_skip_list {
+private:
+    struct Skip_node;
+
+    struct Link {
+        Skip_node* next;
+        T aggregate;
+    };
+
+    // the head is a node without a value. its links cover the nodes in front
+    // of the first node of each level
+    std::vector<Link> head;
+
+public:
+    using key_type = Key;
+    using mapped_type = T;
+
+    using value_type = std::pair<const key_type, mapped_type>;
+    using size_type = std::size_t;
+
+    class const_iterator {
+    public:
+        using value_type = const Augmented_skip_list::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = value_type*;
+        using reference = value_type&;
+        using iterator_category = std::forward_iterator_tag;
+
+        const_iterator() = default;
+
+        constexpr bool operator==(const const_iterator& b) const noexcept
+        {
+            return curr == b.curr;
+        }
+        constexpr bool operator!=(const const_iterator& b) const noexcept
+        {
+            return curr != b.curr;
+        }
+
+        const_iterator& operator++() noexcept
+        {
+            assert(curr != nullptr);
+
+            curr = curr->links[0].next;
+            return *this;
+        }
+
+        const_iterator operator++(int) noexcept
+        {
+            assert(curr != nullptr);
+
+            auto temp = *this;
+            operator++();
+            return temp;
+        }
+
+        constexpr value_type& operator*() const noexcept
+        {
+            return curr->value;
+        }
+
+        constexpr value_type* operator->() const noexcept
+        {
+            return &curr->value;
+        }
+
+    private:
+        explicit constexpr const_iterator(const Skip_node* pos) noexcept
+            : curr{pos} {};
+
+        const Skip_node* curr = nullptr;
+
+        friend class Augmented_skip_list;
+    };
+
+    using iterator = const_iterator;
+
+    explicit Augmented_skip_list(Monoid op = Monoid{})
+        : head(1, Link{nullptr, op.identity()}), monoid{std::move(op)}
+    {
+    }
+
+    ~Augmented_skip_list()
+    {
+        free_all_nodes(head[0].next);
+    }
+
+    Augmented_skip_list(const Augmented_skip_list& other)
+        : Augmented_skip_list{other.monoid}
+    {
+        for (const auto& value : other) {
+            insert(value);
+        }
+    }
+
+    Augmented_skip_list& operator=(const Augmented_skip_list& other)
+    {
+        auto temp = other;
+        swap(temp, *this);
+        return *this;
+    }
+
+    friend void swap(Augmented_skip_list& a, Augmented_skip_list& b) noexcept
+    {
+        using std::swap;
+        swap(a.head, b.head);
+        swap(a.monoid, b.monoid);
+    }
+
+    Augmented_skip_list(Augmented_skip_list&& other) noexcept
+        : Augmented_skip_list{other.monoid}
+    {
+        swap(*this, other);
+    }
+
+    Augmented_skip_list& operator=(Augmented_skip_list&& other) noexcept
+    {
+        swap(*this, other);
+        return *this;
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return const_iterator{head[0].next};
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator{nullptr};
+    }
+
+    bool empty() const noexcept
+    {
+        return head[0].next == nullptr;
+    }
+
+    size_type size() const noexcept // return count of nodes
+    {
+        auto counter = size_type{};
+
+        for (auto index = head[0].next; index != nullptr;
+             index = index->links[0].next, ++counter)
+            ;
+
+        return counter;
+    }
+
+    std::pair<const_iterator, bool> insert(const value_type& value);
+
+    size_type erase(const key_type& key);
+
+    void clear() noexcept
+    {
+        free_all_nodes(head[0].next);
+        head.assign(1, Link{nullptr, monoid.identity()});
+    }
+
+    const_iterator find(const key_type& key) const;
+    const_iterator lower_bound(const key_type& key) const;
+
+    size_type count(const key_type& key) const
+    {
+        return find(key) != end() ? 1 : 0;
+    }
+
+    // combination of the values of all elements with lo <= key < hi
+    mapped_type aggregate(const key_type& lo, const key_type& hi) const;
+
+    // combination of the values of all elements
+    mapped_type aggregate() const;
+
+    size_type top_level() const
+    {
+        return head.size();
+    }
+
+private:
+    static constexpr size_type max_level = detail::fixed_path_levels;
+
+    struct Skip_node {
+        value_type value; // key / T
+        size_type levels;
+        Link links[1];
+
+        const key_type& key() const noexcept
+        {
+            return value.first;
+        }
+    };
+
+    void search_path(const key_type& key, Link* path[]);
+    void update_link(Link* links, size_type level) const;
+
+    size_type generate_level() const
+    {
+        return detail::generate_level(head.size(), max_level);
+    }
+
+    Skip_node* allocate_node(const value_type& value, size_type levels) const;
+    static void free_node(Skip_node* node) noexcept;
+    static void free_all_nodes(Skip_node* head) noexcept;
+
+    Monoid monoid;
+};
+
+template <typename Key, typename T, typename Monoid>
+std::pair<typename Augmented_skip_list<Key, T, Monoid>::const_iterator, bool>
+Augmented_skip_list<Key, T, Monoid>::insert(const value_type& value)
+// if the key is present its value is replaced. in both cases the links on the
+// search path are recomputed from the level below, bottom up. on each level
+// only the link spanning the changed node and, for a new node, the links of
+// the node itself change
+{
+    const auto& key = value.first;
+
+    const auto insert_level = generate_level();
+    while (head.size() < insert_level) { // before the path points into head
+        head.push_back(Link{nullptr, monoid.identity()});
+    }
+
+    Link* path[max_level];
+    search_path(key, path);
+
+    auto node = path[0][0].next;
+
+    if (node && node->key() == key) {
+        node->value.second = value.second;
+        node->links[0].aggregate = value.second;
+
+        for (auto i = size_type{1}; i < head.size(); ++i) {
+            update_link(i < node->levels ? node->links : path[i], i);
+        }
+
+        while (head.size() > 1 && head.back().next == nullptr) {
+            head.pop_back();
+        }
+        return std::make_pair(const_iterator{node}, false);
+    }
+
+    node = allocate_node(value, insert_level);
+
+    for (auto i = size_type{}; i < insert_level; ++i) {
+        node->links[i].next = path[i][i].next;
+        path[i][i].next = node;
+    }
+
+    for (auto i = size_type{1}; i < head.size(); ++i) {
+        if (i < insert_level) {
+            update_link(node->links, i);
+        }
+        update_link(path[i], i);
+    }
+
+    return std::make_pair(const_iterator{node}, true);
+}
+
+template <typename Key, typename T, typename Monoid>
+typename Augmented_skip_list<Key, T, Monoid>::size_type
+Augmented_skip_list<Key, T, Monoid>::erase(const key_type& key)
+// the predecessors take over the links of the node. afterwards every
+// predecessor spans what the node did, so they are recomputed bottom up
+{
+    Link* path[max_level];
+    search_path(key, path);
+
+    const auto node = path[0][0].next;
+
+    if (!node || !(node->key() == key)) {
+        return 0;
+    }
+
+    for (auto i = size_type{}; i < node->levels; ++i) {
+        path[i][i].next = node->links[i].next;
+    }
+
+    for (auto i = size_type{1}; i < head.size(); ++i) {
+        update_link(path[i], i);
+    }
+
+    free_node(node);
+
+    while (head.size() > 1 && head.back().next == nullptr) {
+        head.pop_back();
+    }
+    return 1;
+}
+
+template <typename Key, typename T, typename Monoid>
+typename Augmented_skip_list<Key, T, Monoid>::const_iterator
+Augmented_skip_list<Key, T, Monoid>::find(const key_type& key) const
+{
+    const auto it = lower_bound(key);
+    return it != end() && it->first == key ? it : end();
+}
+
+template <typename Key, typename T, typename Monoid>
+typename Augmented_skip_list<Key, T, Monoid>::const_iterator
+Augmented_skip_list<Key, T, Monoid>::lower_bound(const key_type& key) const
+{
+    auto level = head.size();
+    auto links = head.data();
+
+    while (level > 0) {
+        const auto index = level - 1;
+
+        if (!links[index].next || !(key > links[index].next->key())) {
+            --level;
+        }
+        else {
+            links = links[index].next->links;
+        }
+    }
+    return const_iterator{links[0].next};
+}
+
+template <typename Key, typename T, typename Monoid>
+typename Augmented_skip_list<Key, T, Monoid>::mapped_type
+Augmented_skip_list<Key, T, Monoid>::aggregate(const key_type& lo,
+                                               const key_type& hi) const
+// starts at the first node of the range and always takes the highest link of
+// the current node which still ends inside the range. towers get taller
+// towards the middle of the range and shorter towards its end, like a search
+// going up and then down again, so the expected count of steps is O(log n)
+{
+    auto result = monoid.identity();
+
+    for (auto node = lower_bound(lo).curr; node && hi > node->key();) {
+        auto index = node->levels - 1;
+
+        while (index > 0 && (!node->links[index].next ||
+                             node->links[index].next->key() > hi)) {
+            --index;
+        }
+
+        result = monoid(result, node->links[index].aggregate);
+        node = node->links[index].next;
+    }
+    return result;
+}
+
+template <typename Key, typename T, typename Monoid>
+typename Augmented_skip_list<Key, T, Monoid>::mapped_type
+Augmented_skip_list<Key, T, Monoid>::aggregate() const
+// the top level links together span the whole list
+{
+    const auto index = head.size() - 1;
+
+    auto result = head[index].aggregate;
+    for (auto node = head[index].next; node; node = node->links[index].next) {
+        result = monoid(result, node->links[index].aggregate);
+    }
+    return result;
+}
+
+template <typename Key, typename T, typename Monoid>
+void Augmented_skip_list<Key, T, Monoid>::search_path(const key_type& key,
+                                                 Link* path[])
+// stores for each level the links of the last node with a smaller key
+{
+    auto level = head.size();
+    auto links = head.data();
+
+    while (level > 0) {
+        const auto index = level - 1;
+
+        if (!links[index].next || !(key > links[index].next->key())) {
+            path[index] = links;
+            --level;
+        }
+        else {
+            links = links[index].next->links;
+        }
+    }
+}
+
+template <typename Key, typename T, typename Monoid>
+void Augmented_skip_list<Key, T, Monoid>::update_link(Link* links,
+                                                      size_type level) const
+// a link combines the links one level below which lie between its start and
+// its end. precondition: level > 0 and the lower level is up to date
+{
+    const auto below = level - 1;
+    const auto end = links[level].next;
+
+    auto result = links[below].aggregate;
+    for (auto node = links[below].next; node != end;
+         node = node->links[below].next) {
+        result = monoid(result, node->links[below].aggregate);
+    }
+    links[level].aggregate = std::move(result);
+}
+
+template <typename Key, typename T, typename Monoid>
+typename Augmented_skip_list<Key, T, Monoid>::Skip_node*
+Augmented_skip_list<Key, T, Monoid>::allocate_node(const value_type& value,
+                                                   size_type levels) const
+// the level 0 link spans only the node itself. the higher ones are filled in
+// by update_link after linking
+{
+    static_assert(std::is_nothrow_copy_constructible_v<T>,
+                  "aggregates are copied while the list is relinked");
+
+    const auto node_size = sizeof(Skip_node) + (levels - 1) * sizeof(Link);
+
+    const auto node = std::aligned_alloc(alignof(Skip_node), node_size);
+    const auto skip_node = new (node) Skip_node{
+        value, levels, {Link{nullptr, value.second}}};
+
+    for (auto i = size_type{1}; i < levels; ++i) {
+        new (&skip_node->links[i]) Link{nullptr, monoid.identity()};
+    }
+    return skip_node;
+}
+
+template <typename Key, typename T, typename Monoid>
+void Augmented_skip_list<Key, T, Monoid>::free_node(Skip_node* node) noexcept
+{
+    for (auto i = size_type{1}; i < node->levels; ++i) {
+        node->links[i].~Link();
+    }
+    node->~Skip_node();
+    std::free(node);
+}
+
+template <typename Key, typename T, typename Monoid>
+void Augmented_skip_list<Key, T, Monoid>::free_all_nodes(
+    Skip_node* head) noexcept
+{
+    for (auto index = head; index != nullptr;) {
+        const auto temp = index;
+        index = index->links[0].next;
+        free_node(temp);
+    }
+}
+} // namespace skip_list
+#endif
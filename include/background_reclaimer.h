@@ -0,0 +1,119 @@
+#ifndef BACKGROUND_RECLAIMER_H
+#define BACKGROUND_RECLAIMER_H
+
+#include <condition_variable>
+#include <deque>      // queued jobs
+#include <functional> // std::function
+#include <memory>     // std::shared_ptr
+#include <mutex>
+#include <thread>
+#include <type_traits> // std::decay_t
+#include <utility>     // std::move
+
+namespace skip_list {
+
+// worker thread which destroys containers handed to it, so the thread that
+// drops a large list does not wait until every node is freed:
+//
+//     reclaim_in_background(std::move(list)); // list is empty afterwards
+//
+// the jobs run one after the other in the order they were posted. the
+// destructor finishes all queued jobs before it joins the thread.
+class Background_reclaimer {
+public:
+    Background_reclaimer() : worker{[this] { run(); }}
+    {
+    }
+
+    ~Background_reclaimer()
+    {
+        {
+            const auto lock = std::lock_guard<std::mutex>{mutex};
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    Background_reclaimer(const Background_reclaimer&) = delete;
+    Background_reclaimer& operator=(const Background_reclaimer&) = delete;
+
+    void post(std::function<void()> job)
+    {
+        {
+            const auto lock = std::lock_guard<std::mutex>{mutex};
+            jobs.push_back(std::move(job));
+        }
+        wake.notify_one();
+    }
+
+    // blocks until every job posted before has finished
+    void wait()
+    {
+        auto lock = std::unique_lock<std::mutex>{mutex};
+        idle.wait(lock, [this] { return jobs.empty() && !busy; });
+    }
+
+    // shared by all callers which don't bring their own reclaimer
+    static Background_reclaimer& instance()
+    {
+        static auto reclaimer = Background_reclaimer{};
+        return reclaimer;
+    }
+
+private:
+    void run()
+    {
+        auto lock = std::unique_lock<std::mutex>{mutex};
+
+        for (;;) {
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+
+            if (jobs.empty()) { // stopping and nothing left
+                return;
+            }
+
+            auto job = std::move(jobs.front());
+            jobs.pop_front();
+            busy = true;
+
+            lock.unlock();
+            job();
+            job = nullptr; // whatever the job owns goes here, not locked
+            lock.lock();
+
+            busy = false;
+            if (jobs.empty()) {
+                idle.notify_all();
+            }
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<std::function<void()>> jobs;
+    bool busy = false;
+    bool stopping = false;
+
+    std::thread worker; // last, it starts running in the constructor
+};
+
+// moves the container into a job of reclaimer which destroys it there. the
+// moved from container is left empty like after a move
+template <typename Container>
+void reclaim_in_background(
+    Container&& container,
+    Background_reclaimer& reclaimer = Background_reclaimer::instance())
+{
+    static_assert(!std::is_lvalue_reference_v<Container>,
+                  "pass the container with std::move");
+    using type = std::decay_t<Container>;
+
+    // std::function needs a copyable job, the container is only moved
+    auto owner = std::make_shared<type>(std::move(container));
+    reclaimer.post([owner = std::move(owner)]() mutable { owner.reset(); });
+}
+
+} // namespace skip_list
+#endif
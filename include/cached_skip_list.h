@@ -0,0 +1,303 @@
+#ifndef CACHED_SKIP_LIST_H
+#define CACHED_SKIP_LIST_H
+
+#include "skip_list.h"
+
+#include <cstddef>     // std::size_t
+#include <cstdint>     // std::uint64_t
+#include <functional>  // std::hash
+#include <type_traits> // std::is_nothrow_move_constructible_v
+#include <utility>     // std::pair, std::exchange
+#include <vector>      // cache slots
+
+namespace skip_list {
+
+// Skip list with a small open addressing hash table in front of it which maps
+// recently found keys to their nodes. a point lookup which hits the table
+// skips the O(log n) descent. ordered operations go straight to the towers.
+//
+// a key may sit in any of probe_length slots after its hash position. a
+// lookup checks all of them, so erasing from the table just empties a slot.
+// each slot keeps the hash of its key next to the position, the node is only
+// read when the hashes match. a miss then costs no node access in the usual
+// case, only the descent.
+// when all slots of a key are taken, the CLOCK rule picks the victim: every
+// hit marks a slot, a marked slot gets a second chance and is unmarked, the
+// first unmarked one is replaced.
+//
+// insert and erase update the table so it never points to a freed node.
+template <typename Key, typename T, typename Hash = std::hash<Key>>
+class Cached_skip_list {
+public:
+    using list_type = Skip_list<Key, T>;
+    using key_type = typename list_type::key_type;
+    using mapped_type = typename list_type::mapped_type;
+    using value_type = typename list_type::value_type;
+    using size_type = typename list_type::size_type;
+    using iterator = typename list_type::iterator;
+    using const_iterator = typename list_type::const_iterator;
+
+    // capacity is rounded up to a power of two
+    explicit Cached_skip_list(size_type capacity = 1024, Hash hash = Hash{});
+
+    // a copy would cache positions in the other list
+    Cached_skip_list(const Cached_skip_list&) = delete;
+    Cached_skip_list& operator=(const Cached_skip_list&) = delete;
+
+    // the table moves along, the moved from list works on without a cache
+    Cached_skip_list(Cached_skip_list&& other) noexcept(
+        std::is_nothrow_move_constructible_v<Hash>)
+        : list{std::move(other.list)}, slots{std::exchange(other.slots, {})},
+          hand{std::exchange(other.hand, 0)}, hash{std::move(other.hash)},
+          hit_count{std::exchange(other.hit_count, 0)},
+          miss_count{std::exchange(other.miss_count, 0)}
+    {
+    }
+
+    Cached_skip_list& operator=(Cached_skip_list&& other) noexcept(
+        std::is_nothrow_move_assignable_v<Hash>)
+    {
+        list = std::move(other.list);
+        slots = std::exchange(other.slots, {});
+        hand = std::exchange(other.hand, 0);
+        hash = std::move(other.hash);
+        hit_count = std::exchange(other.hit_count, 0);
+        miss_count = std::exchange(other.miss_count, 0);
+        return *this;
+    }
+
+    iterator begin() noexcept
+    {
+        return list.begin();
+    }
+
+    iterator end() noexcept
+    {
+        return list.end();
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return list.begin();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return list.end();
+    }
+
+    bool empty() const noexcept
+    {
+        return list.empty();
+    }
+
+    size_type size() const noexcept
+    {
+        return list.size();
+    }
+
+    mapped_type& operator[](const key_type& key)
+    {
+        return find(key)->second;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value);
+
+    size_type erase(const key_type& key);
+
+    void clear() noexcept;
+
+    iterator find(const key_type& key);
+
+    size_type count(const key_type& key)
+    {
+        return find(key) != end() ? 1 : 0;
+    }
+
+    iterator lower_bound(const key_type& key)
+    {
+        return list.lower_bound(key);
+    }
+
+    const_iterator lower_bound(const key_type& key) const
+    {
+        return list.lower_bound(key);
+    }
+
+    std::uint64_t hits() const noexcept
+    {
+        return hit_count;
+    }
+
+    std::uint64_t misses() const noexcept
+    {
+        return miss_count;
+    }
+
+    double hit_rate() const noexcept
+    {
+        const auto lookups = hit_count + miss_count;
+        return lookups == 0 ? 0.0 : static_cast<double>(hit_count) / lookups;
+    }
+
+    void reset_statistics() noexcept
+    {
+        hit_count = 0;
+        miss_count = 0;
+    }
+
+private:
+    static constexpr size_type probe_length = 4;
+
+    struct Slot {
+        iterator position; // end() if the slot is empty
+        std::size_t key_hash = 0;
+        bool referenced = false;
+    };
+
+    Slot* lookup(const key_type& key);
+    void remember(iterator position);
+    void forget(const key_type& key);
+
+    size_type slot_index(std::size_t key_hash, size_type probe) const
+    {
+        return (key_hash + probe) & (slots.size() - 1);
+    }
+
+    list_type list;
+    std::vector<Slot> slots;
+    size_type hand = 0; // clock hand inside a probe window
+    Hash hash;
+
+    std::uint64_t hit_count = 0;
+    std::uint64_t miss_count = 0;
+};
+
+template <typename Key, typename T, typename Hash>
+Cached_skip_list<Key, T, Hash>::Cached_skip_list(size_type capacity,
+                                                 Hash hash)
+    : hash{std::move(hash)}
+{
+    auto slot_count = size_type{probe_length};
+    while (slot_count < capacity) {
+        slot_count *= 2;
+    }
+    slots.assign(slot_count, Slot{list.end(), 0, false});
+}
+
+template <typename Key, typename T, typename Hash>
+std::pair<typename Cached_skip_list<Key, T, Hash>::iterator, bool>
+Cached_skip_list<Key, T, Hash>::insert(const value_type& value)
+// inserting a present key can replace its node, so a cached position is
+// refreshed with the one insert reports. the slot is looked up before, while
+// the old node can still be read
+{
+    const auto slot = lookup(value.first);
+    const auto result = list.insert(value);
+
+    if (slot) {
+        slot->position = result.first;
+    }
+    return result;
+}
+
+template <typename Key, typename T, typename Hash>
+typename Cached_skip_list<Key, T, Hash>::size_type
+Cached_skip_list<Key, T, Hash>::erase(const key_type& key)
+{
+    forget(key);
+    return list.erase(key);
+}
+
+template <typename Key, typename T, typename Hash>
+void Cached_skip_list<Key, T, Hash>::clear() noexcept
+{
+    list.clear();
+    for (auto& slot : slots) {
+        slot = Slot{list.end(), 0, false};
+    }
+}
+
+template <typename Key, typename T, typename Hash>
+typename Cached_skip_list<Key, T, Hash>::iterator
+Cached_skip_list<Key, T, Hash>::find(const key_type& key)
+{
+    if (const auto slot = lookup(key)) {
+        ++hit_count;
+        slot->referenced = true;
+        return slot->position;
+    }
+
+    ++miss_count;
+
+    const auto position = list.find(key);
+    if (position != list.end()) {
+        remember(position);
+    }
+    return position;
+}
+
+template <typename Key, typename T, typename Hash>
+typename Cached_skip_list<Key, T, Hash>::Slot*
+Cached_skip_list<Key, T, Hash>::lookup(const key_type& key)
+{
+    if (slots.empty()) { // moved from
+        return nullptr;
+    }
+
+    const auto key_hash = hash(key);
+
+    for (auto probe = size_type{}; probe < probe_length; ++probe) {
+        auto& slot = slots[slot_index(key_hash, probe)];
+
+        if (slot.key_hash == key_hash && slot.position != list.end() &&
+            slot.position->first == key) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+template <typename Key, typename T, typename Hash>
+void Cached_skip_list<Key, T, Hash>::remember(iterator position)
+// takes the first free slot of the window. if there is none the clock hand
+// sweeps the window, clearing marks, until it finds an unmarked slot. after
+// one round every mark is cleared, so this ends after probe_length + 1 steps
+{
+    if (slots.empty()) {
+        return;
+    }
+
+    const auto key_hash = hash(position->first);
+
+    for (auto probe = size_type{}; probe < probe_length; ++probe) {
+        auto& slot = slots[slot_index(key_hash, probe)];
+
+        if (slot.position == list.end()) {
+            slot = Slot{position, key_hash, false};
+            return;
+        }
+    }
+
+    for (;;) {
+        auto& slot = slots[slot_index(key_hash, hand)];
+        hand = (hand + 1) % probe_length;
+
+        if (!slot.referenced) {
+            slot = Slot{position, key_hash, false};
+            return;
+        }
+        slot.referenced = false;
+    }
+}
+
+template <typename Key, typename T, typename Hash>
+void Cached_skip_list<Key, T, Hash>::forget(const key_type& key)
+{
+    if (const auto slot = lookup(key)) {
+        *slot = Slot{list.end(), 0, false};
+    }
+}
+
+} // namespace skip_list
+#endif
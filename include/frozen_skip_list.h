@@ -0,0 +1,215 @@
+#ifndef FROZEN_SKIP_LIST_H
+#define FROZEN_SKIP_LIST_H
+
+#include "skip_list.h"
+
+#include <cstddef>     // std::size_t
+#include <cstdint>     // std::uintptr_t
+#include <type_traits> // std::is_void_v
+#include <utility>     // std::pair, std::move
+#include <vector>      // layout and elements
+
+namespace skip_list {
+
+// read only copy of a Skip_list for data which is built once and then only
+// searched. the elements are stored in key order in one array, which is what
+// iteration walks. the keys are stored a second time in Eytzinger order, the
+// breadth first order of a complete binary search tree: the children of
+// position k are 2k and 2k + 1. the first levels of the tree share a few
+// cache lines and the search has no data dependent branch: every step is
+// k = 2k + (key > layout[k]). the keys_per_line descendants of a position
+// log2(keys_per_line) levels below it start at k * keys_per_line and lie next
+// to each other, in one or two cache lines: 16 of them 4 levels down for int
+// keys, 8 of them 3 levels down for 8 byte keys. the search prefetches there
+// while the steps in between run, so the descent overlaps its memory
+// accesses.
+//
+// built with freeze() from a list, turned back into a Skip_list with thaw().
+template <typename Key, typename T> class Frozen_skip_list {
+public:
+    static_assert(!std::is_void_v<T>, "sets are not supported");
+
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const key_type, mapped_type>;
+    using size_type = std::size_t;
+
+    using const_iterator = const value_type*;
+    using iterator = const_iterator;
+
+    Frozen_skip_list() = default;
+
+    // precondition: elements sorted by key and the keys unique
+    explicit Frozen_skip_list(std::vector<value_type> elements);
+
+    const_iterator begin() const noexcept
+    {
+        return elements.data();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return elements.data() + elements.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return elements.empty();
+    }
+
+    size_type size() const noexcept
+    {
+        return elements.size();
+    }
+
+    const_iterator find(const key_type& key) const
+    {
+        const auto position = lower_bound(key);
+        return position != end() && position->first == key ? position : end();
+    }
+
+    const_iterator lower_bound(const key_type& key) const;
+
+    const_iterator upper_bound(const key_type& key) const
+    {
+        const auto position = lower_bound(key);
+        return position != end() && position->first == key ? position + 1
+                                                            : position;
+    }
+
+    std::pair<const_iterator, const_iterator>
+    equal_range(const key_type& key) const
+    {
+        return std::make_pair(lower_bound(key), upper_bound(key));
+    }
+
+    size_type count(const key_type& key) const
+    {
+        return find(key) != end() ? 1 : 0;
+    }
+
+    // the mutable list again, the elements are copied
+    template <typename List = Skip_list<Key, T>> List thaw() const
+    {
+        auto list = List{};
+        for (const auto& element : elements) {
+            list.insert(element);
+        }
+        return list;
+    }
+
+    void clear() noexcept
+    {
+        elements.clear();
+        layout.clear();
+        ranks.clear();
+    }
+
+private:
+    size_type build(size_type rank, size_type position);
+
+    static void prefetch(const void* address) noexcept
+    {
+#if defined(__GNUC__)
+        __builtin_prefetch(address);
+#endif
+    }
+
+    // keys of one cache line, 1 for keys of a cache line or more. position
+    // * keys_per_line is the first of the descendants prefetched
+    static constexpr size_type keys_per_line =
+        sizeof(key_type) < 64 ? 64 / sizeof(key_type) : 1;
+
+    std::vector<value_type> elements; // sorted
+    std::vector<key_type> layout;     // position k at index k - 1
+    std::vector<size_type> ranks;     // index in elements per position
+};
+
+template <typename Key, typename T>
+Frozen_skip_list<Key, T>::Frozen_skip_list(std::vector<value_type> elements)
+    : elements{std::move(elements)}
+{
+    ranks.resize(this->elements.size());
+    build(0, 1);
+
+    layout.reserve(this->elements.size());
+    for (const auto rank : ranks) {
+        layout.push_back(this->elements[rank].first);
+    }
+}
+
+template <typename Key, typename T>
+typename Frozen_skip_list<Key, T>::size_type
+Frozen_skip_list<Key, T>::build(size_type rank, size_type position)
+// an in order walk of the implicit tree hands out the ranks in order. the
+// recursion is as deep as the tree, O(log n)
+{
+    if (position <= ranks.size()) {
+        rank = build(rank, 2 * position);
+        ranks[position - 1] = rank++;
+        rank = build(rank, 2 * position + 1);
+    }
+    return rank;
+}
+
+template <typename Key, typename T>
+typename Frozen_skip_list<Key, T>::const_iterator
+Frozen_skip_list<Key, T>::lower_bound(const key_type& key) const
+// the descent goes right past every key smaller than key and ends below a
+// leaf. the last step to the left was at the answer: dropping the trailing
+// ones of the position and the zero in front of them leads back to it. the
+// position is 0 if there was no step to the left, all keys are smaller
+{
+    const auto n = layout.size();
+    const auto base = reinterpret_cast<std::uintptr_t>(layout.data());
+
+    auto position = size_type{1};
+    while (position <= n) {
+        // may point behind the array, a prefetch does not fault
+        prefetch(reinterpret_cast<const void*>(
+            base + (position * keys_per_line - 1) * sizeof(key_type)));
+        position = 2 * position + (key > layout[position - 1] ? 1 : 0);
+    }
+
+#if defined(__GNUC__)
+    position >>=
+        __builtin_ctzll(~static_cast<unsigned long long>(position)) + 1;
+#else
+    while (position & 1) {
+        position >>= 1;
+    }
+    position >>= 1;
+#endif
+
+    return position == 0 ? end() : begin() + ranks[position - 1];
+}
+
+// copies the elements of list into a read only index
+template <typename Key, typename T, std::size_t MaxLevel, typename Storage>
+Frozen_skip_list<Key, T>
+freeze(const Skip_list<Key, T, MaxLevel, false, Storage>& list)
+{
+    auto elements =
+        std::vector<typename Frozen_skip_list<Key, T>::value_type>{};
+    for (const auto& element : list) {
+        elements.push_back(element);
+    }
+    return Frozen_skip_list<Key, T>{std::move(elements)};
+}
+
+// moves the values out of list, the list is empty afterwards. the keys are
+// copied, they are const in the nodes
+template <typename Key, typename T, std::size_t MaxLevel, typename Storage>
+Frozen_skip_list<Key, T>
+freeze(Skip_list<Key, T, MaxLevel, false, Storage>&& list)
+{
+    auto elements =
+        std::vector<typename Frozen_skip_list<Key, T>::value_type>{};
+    while (!list.empty()) {
+        elements.push_back(list.extract_min());
+    }
+    return Frozen_skip_list<Key, T>{std::move(elements)};
+}
+
+} // namespace skip_list
+#endif
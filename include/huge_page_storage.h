@@ -0,0 +1,337 @@
+#ifndef HUGE_PAGE_STORAGE_H
+#define HUGE_PAGE_STORAGE_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib> // aligned_alloc() and free() where there is no mmap
+#include <mutex>   // the pool is shared by all lists of one storage type
+#include <new>     // std::bad_alloc
+#include <unordered_map> // flags of the large node mappings
+#include <vector>  // free lists
+
+#if defined(__linux__)
+#include <sys/mman.h>    // mmap(), madvise()
+#include <sys/syscall.h> // SYS_mbind
+#include <unistd.h>      // syscall()
+#endif
+
+namespace skip_list {
+
+enum class Numa_mode {
+    local,      // first touch, the kernel default
+    preferred,  // the first node of the mask if it has memory left
+    bind,       // only the nodes of the mask
+    interleave, // pages round robin over the nodes of the mask
+};
+
+struct Numa_placement {
+    Numa_mode mode = Numa_mode::local;
+    std::uint64_t nodes = 0; // bit n selects NUMA node n
+};
+
+// node storage for Skip_list<Key, T, MaxLevel, Multi, Huge_page_storage<>>.
+// nodes are carved out of 2 MiB chunks so a large list touches a few huge
+// pages instead of one 4 KiB page per node, which takes most TLB misses out
+// of the descent. a chunk is mapped with MAP_HUGETLB if the system has
+// reserved huge pages, otherwise it is mapped 2 MiB aligned and advised as
+// MADV_HUGEPAGE for transparent huge pages.
+//
+// set_placement() sets a NUMA policy which mbind applies to every chunk
+// mapped afterwards, before its pages are touched. the lists of one Tag share
+// one pool, so Huge_page_storage<Socket_0> and Huge_page_storage<Socket_1>
+// can keep e.g. one list per socket on its local memory.
+//
+// freed nodes go to a free list per size and are reused by the next node of
+// the same size, chunks are only given back at exit. copying and compacting
+// a list take fresh memory, so the new nodes lie in key order. nodes bigger
+// than large_size get a mapping of their own which is unmapped on
+// deallocate.
+// all functions are thread safe.
+template <typename Tag = void> class Huge_page_storage {
+public:
+    static constexpr std::size_t chunk_size = std::size_t{2} << 20;
+    static constexpr std::size_t large_size = chunk_size / 8;
+    static constexpr std::size_t sequence_length = 1024;
+
+    struct Statistics {
+        std::size_t chunks = 0;        // mappings of chunk_size or larger
+        std::size_t huge_chunks = 0;   // of them backed by MAP_HUGETLB
+        std::size_t bound_chunks = 0;  // of them placed with mbind
+        std::size_t bytes_in_use = 0;  // handed out and not deallocated
+    };
+
+    static void* allocate(std::size_t size, std::size_t alignment);
+    static void deallocate(void* p, std::size_t size,
+                           std::size_t alignment) noexcept;
+
+    // skips the free lists, so nodes copied or compacted in key order lie
+    // one behind the other in the current chunk. locks the pool once
+    static void allocate_sequence(std::size_t count, const std::size_t* sizes,
+                                  std::size_t alignment, void** out);
+
+    static void set_placement(Numa_placement placement)
+    {
+        auto& state = pool();
+        const auto lock = std::lock_guard<std::mutex>{state.mutex};
+        state.placement = placement;
+    }
+
+    static Statistics statistics()
+    {
+        auto& state = pool();
+        const auto lock = std::lock_guard<std::mutex>{state.mutex};
+        return state.statistics;
+    }
+
+private:
+    static constexpr std::size_t granularity = 16;
+
+    struct Free_block {
+        Free_block* next;
+    };
+
+    // how a mapping turned out, kept for each large node so unmapping it
+    // takes it off the right counters
+    enum Mapping_flags : unsigned { huge_mapping = 1, bound_mapping = 2 };
+
+    struct Pool {
+        std::mutex mutex;
+        Numa_placement placement;
+        Statistics statistics;
+        std::unordered_map<void*, unsigned> large_mappings;
+
+        char* cursor = nullptr; // unused rest of the current chunk
+        char* limit = nullptr;
+        std::vector<Free_block*> free_lists; // index is size / granularity
+    };
+
+    static Pool& pool()
+    {
+        static auto instance = Pool{};
+        return instance;
+    }
+
+    static constexpr std::size_t round_up(std::size_t value,
+                                          std::size_t multiple) noexcept
+    {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+    // precondition of both: state is locked
+    static void* allocate(Pool& state, std::size_t size,
+                          std::size_t alignment, bool reuse);
+    static void release(Pool& state, void* p, std::size_t size,
+                        std::size_t alignment) noexcept;
+
+    static void* map(Pool& state, std::size_t bytes, unsigned& flags);
+    static void unmap(Pool& state, void* p, std::size_t bytes,
+                      unsigned flags) noexcept;
+};
+
+template <typename Tag>
+void* Huge_page_storage<Tag>::allocate(std::size_t size, std::size_t alignment)
+{
+    auto& state = pool();
+    const auto lock = std::lock_guard<std::mutex>{state.mutex};
+    return allocate(state, size, alignment, true);
+}
+
+template <typename Tag>
+void Huge_page_storage<Tag>::allocate_sequence(std::size_t count,
+                                               const std::size_t* sizes,
+                                               std::size_t alignment,
+                                               void** out)
+{
+    auto& state = pool();
+    const auto lock = std::lock_guard<std::mutex>{state.mutex};
+
+    auto i = std::size_t{};
+    try {
+        for (; i < count; ++i) {
+            out[i] = allocate(state, sizes[i], alignment, false);
+        }
+    }
+    catch (...) {
+        while (i > 0) {
+            --i;
+            release(state, out[i], sizes[i], alignment);
+        }
+        throw;
+    }
+}
+
+template <typename Tag>
+void Huge_page_storage<Tag>::deallocate(void* p, std::size_t size,
+                                        std::size_t alignment) noexcept
+{
+    auto& state = pool();
+    const auto lock = std::lock_guard<std::mutex>{state.mutex};
+    release(state, p, size, alignment);
+}
+
+template <typename Tag>
+void* Huge_page_storage<Tag>::allocate(Pool& state, std::size_t size,
+                                       std::size_t alignment, bool reuse)
+{
+    alignment = alignment < granularity ? granularity : alignment;
+    size = round_up(size, alignment);
+
+    if (size > large_size) {
+        const auto bytes = round_up(size, chunk_size);
+        auto flags = 0u;
+        const auto p = map(state, bytes, flags);
+        try {
+            state.large_mappings.emplace(p, flags);
+        }
+        catch (...) {
+            unmap(state, p, bytes, flags);
+            throw;
+        }
+        state.statistics.bytes_in_use += size;
+        return p;
+    }
+
+    const auto index = size / granularity;
+    if (reuse && index < state.free_lists.size()) {
+        auto& list = state.free_lists[index];
+
+        if (list && reinterpret_cast<std::uintptr_t>(list) % alignment == 0) {
+            const auto block = list;
+            list = block->next;
+            state.statistics.bytes_in_use += size;
+            return block;
+        }
+    }
+
+    auto begin = reinterpret_cast<char*>(
+        round_up(reinterpret_cast<std::uintptr_t>(state.cursor), alignment));
+
+    if (state.cursor == nullptr || begin + size > state.limit) {
+        auto flags = 0u; // chunks stay mapped, nothing to remember
+        state.cursor = static_cast<char*>(map(state, chunk_size, flags));
+        state.limit = state.cursor + chunk_size;
+        begin = state.cursor;
+    }
+
+    state.cursor = begin + size;
+    state.statistics.bytes_in_use += size;
+    return begin;
+}
+
+template <typename Tag>
+void Huge_page_storage<Tag>::release(Pool& state, void* p, std::size_t size,
+                                     std::size_t alignment) noexcept
+{
+    alignment = alignment < granularity ? granularity : alignment;
+    size = round_up(size, alignment);
+
+    if (size > large_size) {
+        const auto mapping = state.large_mappings.find(p);
+        assert(mapping != state.large_mappings.end());
+
+        const auto flags = mapping->second;
+        state.large_mappings.erase(mapping);
+        state.statistics.bytes_in_use -= size;
+        unmap(state, p, round_up(size, chunk_size), flags);
+        return;
+    }
+
+    const auto index = size / granularity;
+    if (index >= state.free_lists.size()) {
+        state.free_lists.resize(index + 1, nullptr);
+    }
+
+    const auto block = new (p) Free_block{state.free_lists[index]};
+    state.free_lists[index] = block;
+    state.statistics.bytes_in_use -= size;
+}
+
+template <typename Tag>
+void* Huge_page_storage<Tag>::map(Pool& state, std::size_t bytes,
+                                  unsigned& flags)
+// precondition: bytes is a multiple of chunk_size, state is locked
+{
+    flags = 0;
+
+#if defined(__linux__)
+    auto p = static_cast<char*>(MAP_FAILED);
+
+#if defined(MAP_HUGETLB)
+    p = static_cast<char*>(mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1,
+                                0));
+    if (p != MAP_FAILED) {
+        ++state.statistics.huge_chunks;
+        flags |= huge_mapping;
+    }
+#endif
+
+    if (p == MAP_FAILED) {
+        // map one chunk more and cut it down to a 2 MiB aligned range, so the
+        // kernel can back it with transparent huge pages
+        const auto raw = static_cast<char*>(
+            mmap(nullptr, bytes + chunk_size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (raw == MAP_FAILED) {
+            throw std::bad_alloc{};
+        }
+
+        p = reinterpret_cast<char*>(
+            round_up(reinterpret_cast<std::uintptr_t>(raw), chunk_size));
+        if (p != raw) {
+            munmap(raw, static_cast<std::size_t>(p - raw));
+        }
+        munmap(p + bytes, static_cast<std::size_t>(raw + chunk_size - p));
+
+#if defined(MADV_HUGEPAGE)
+        madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+    }
+
+#if defined(SYS_mbind)
+    if (state.placement.mode != Numa_mode::local) {
+        // values of MPOL_PREFERRED, MPOL_BIND and MPOL_INTERLEAVE from
+        // <linux/mempolicy.h>, so libnuma is not needed
+        const int modes[] = {0, 1, 2, 3};
+        const auto mode = modes[static_cast<int>(state.placement.mode)];
+        const auto mask = static_cast<unsigned long>(state.placement.nodes);
+
+        if (syscall(SYS_mbind, p, bytes, mode, &mask, sizeof(mask) * 8 + 1,
+                    0) == 0) {
+            ++state.statistics.bound_chunks;
+            flags |= bound_mapping;
+        }
+    }
+#endif
+
+    ++state.statistics.chunks;
+    return p;
+#else
+    const auto p = std::aligned_alloc(chunk_size, bytes);
+    if (p == nullptr) {
+        throw std::bad_alloc{};
+    }
+    ++state.statistics.chunks;
+    return p;
+#endif
+}
+
+template <typename Tag>
+void Huge_page_storage<Tag>::unmap(Pool& state, void* p, std::size_t bytes,
+                                   unsigned flags) noexcept
+{
+    --state.statistics.chunks;
+    state.statistics.huge_chunks -= (flags & huge_mapping) ? 1 : 0;
+    state.statistics.bound_chunks -= (flags & bound_mapping) ? 1 : 0;
+
+#if defined(__linux__)
+    munmap(p, bytes);
+#else
+    (void)bytes;
+    std::free(p);
+#endif
+}
+
+} // namespace skip_list
+#endif
@@ -0,0 +1,358 @@
+#ifndef MEMTABLE_H
+#define MEMTABLE_H
+
+#include "skip_list.h"
+
+#include <cassert>
+#include <cstdint>     // sequence numbers, fixed width encoding
+#include <cstring>     // std::memcpy
+#include <limits>      // newest snapshot
+#include <ostream>     // flush target
+#include <string>      // encoded blocks
+#include <string_view> // raw key bytes
+#include <type_traits> // detection of capacity() and encodable types
+#include <utility>     // std::move
+
+namespace skip_list {
+
+enum class Entry_kind : std::uint8_t { value, tombstone };
+
+// key of a memtable entry. entries are sorted by user key ascending and for
+// the same user key by sequence descending, so the newest version of a key
+// is found first. the kind takes no part in the order
+template <typename Key> struct Internal_key {
+    Key user_key;
+    std::uint64_t sequence;
+    Entry_kind kind;
+
+    friend bool operator==(const Internal_key& a, const Internal_key& b)
+    {
+        return a.sequence == b.sequence && a.user_key == b.user_key;
+    }
+    friend bool operator!=(const Internal_key& a, const Internal_key& b)
+    {
+        return !(a == b);
+    }
+    friend bool operator<(const Internal_key& a, const Internal_key& b)
+    {
+        if (a.user_key < b.user_key) {
+            return true;
+        }
+        if (b.user_key < a.user_key) {
+            return false;
+        }
+        return a.sequence > b.sequence;
+    }
+    friend bool operator>(const Internal_key& a, const Internal_key& b)
+    {
+        return b < a;
+    }
+};
+
+// dynamic memory of a key or value the memtable counts on top of the nodes.
+// capacity() of strings and vectors of trivial types, nothing for the rest
+struct Heap_bytes {
+    template <typename U> std::size_t operator()(const U& value) const
+    {
+        if constexpr (has_capacity<U>::value) {
+            return value.capacity() * sizeof(typename U::value_type);
+        }
+        else {
+            return 0;
+        }
+    }
+
+private:
+    template <typename U, typename = void>
+    struct has_capacity : std::false_type {
+    };
+    template <typename U>
+    struct has_capacity<U, std::void_t<decltype(std::declval<U>().capacity()),
+                                       typename U::value_type>>
+        : std::bool_constant<
+              std::is_trivially_copyable_v<typename U::value_type>> {
+    };
+};
+
+// encodes keys and values for Memtable::flush as raw bytes: arithmetic types
+// and enums in host byte order, strings with their characters
+struct Raw_codec {
+    template <typename U>
+    void operator()(const U& value, std::string& out) const
+    {
+        if constexpr (std::is_arithmetic_v<U> || std::is_enum_v<U>) {
+            char bytes[sizeof(U)];
+            std::memcpy(bytes, &value, sizeof(U));
+            out.append(bytes, sizeof(U));
+        }
+        else {
+            const auto view = std::string_view{value};
+            out.append(view.data(), view.size());
+        }
+    }
+};
+
+// write buffer of an LSM tree on top of a Skip_list. every put and remove
+// appends a new entry under (key, sequence), nothing is overwritten or
+// physically erased: remove appends a tombstone. a lookup sees the newest
+// entry of the key up to a snapshot sequence.
+//
+// approximate_memory_usage() sums the nodes and the heap memory of keys and
+// values (see Heap_bytes) as they are added, for deciding when to flush.
+// freeze() makes the table read only, flush() then streams level 0 into a
+// sorted run of blocks:
+//
+//     run   := block* index footer
+//     block := entry*                               about block_size bytes
+//     entry := varint key size, key, varint (sequence << 1 | tombstone),
+//              varint value size, value             a tombstone has no value
+//     index := per block: varint last key size, last key, varint offset,
+//              varint size
+//     footer:= fixed64 index offset, fixed64 index size, fixed64 entries,
+//              fixed64 run_magic                    little endian
+//
+// the memtable is not thread safe, writers have to be serialized like in
+// the rest of the library.
+template <typename Key, typename T, typename Size = Heap_bytes>
+class Memtable {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using sequence_type = std::uint64_t;
+    using internal_key_type = Internal_key<Key>;
+    using list_type = Skip_list<internal_key_type, T>;
+    using value_type = typename list_type::value_type;
+    using size_type = typename list_type::size_type;
+    using const_iterator = typename list_type::const_iterator;
+
+    enum class Lookup { found, deleted, missing };
+
+    static constexpr sequence_type newest =
+        std::numeric_limits<sequence_type>::max() >> 1;
+    static constexpr std::uint64_t run_magic = 0x736b69706d656d31; // skipmem1
+
+    explicit Memtable(Size heap_bytes = Size{})
+        : heap_bytes{std::move(heap_bytes)}
+    {
+    }
+
+    // sequence numbers are assigned one after the other from 1 on
+    sequence_type put(const key_type& key, const mapped_type& value)
+    {
+        const auto sequence = last + 1;
+        put(key, value, sequence);
+        return sequence;
+    }
+
+    sequence_type remove(const key_type& key)
+    {
+        const auto sequence = last + 1;
+        remove(key, sequence);
+        return sequence;
+    }
+
+    // with a sequence of the caller, e.g. from a write ahead log. the pair
+    // of key and sequence has to be new. later automatic numbers continue
+    // behind the highest sequence seen
+    void put(const key_type& key, const mapped_type& value,
+             sequence_type sequence)
+    {
+        add(internal_key_type{key, sequence, Entry_kind::value}, value);
+    }
+
+    void remove(const key_type& key, sequence_type sequence)
+    {
+        add(internal_key_type{key, sequence, Entry_kind::tombstone},
+            mapped_type{});
+    }
+
+    // newest entry of key with a sequence up to snapshot. value is only
+    // written if it is found
+    Lookup get(const key_type& key, mapped_type& value,
+               sequence_type snapshot = newest) const;
+
+    // all entries in flush order: key ascending, newest version first
+    const_iterator begin() const noexcept
+    {
+        return list.begin();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return list.end();
+    }
+
+    bool empty() const noexcept
+    {
+        return list.empty();
+    }
+
+    size_type entries() const noexcept
+    {
+        return entry_count;
+    }
+
+    sequence_type last_sequence() const noexcept
+    {
+        return last;
+    }
+
+    std::size_t approximate_memory_usage() const noexcept
+    {
+        return memory;
+    }
+
+    void freeze() noexcept
+    {
+        is_frozen = true;
+    }
+
+    bool frozen() const noexcept
+    {
+        return is_frozen;
+    }
+
+    // writes all entries as a sorted run, returns the count of bytes
+    // written. precondition: frozen()
+    template <typename Codec = Raw_codec>
+    std::uint64_t flush(std::ostream& out, std::size_t block_size = 4096,
+                        Codec codec = Codec{}) const;
+
+private:
+    void add(const internal_key_type& key, const mapped_type& value);
+
+    static void put_varint(std::uint64_t value, std::string& out);
+    static void put_fixed64(std::uint64_t value, std::string& out);
+
+    list_type list;
+    Size heap_bytes;
+
+    size_type entry_count = 0;
+    sequence_type last = 0;
+    std::size_t memory = 0;
+    bool is_frozen = false;
+};
+
+template <typename Key, typename T, typename Size>
+void Memtable<Key, T, Size>::add(const internal_key_type& key,
+                                 const mapped_type& value)
+// the node size is estimated from its height, the exact layout is private
+// to Skip_list
+{
+    assert(!is_frozen);
+    assert(key.sequence <= newest);
+    assert(list.find(key) == list.end());
+
+    const auto position = list.insert(value_type{key, value}).first;
+
+    memory += sizeof(value_type) + sizeof(size_type) +
+              list.level(position) * sizeof(void*) +
+              heap_bytes(key.user_key) + heap_bytes(value);
+    ++entry_count;
+    last = key.sequence > last ? key.sequence : last;
+}
+
+template <typename Key, typename T, typename Size>
+typename Memtable<Key, T, Size>::Lookup
+Memtable<Key, T, Size>::get(const key_type& key, mapped_type& value,
+                            sequence_type snapshot) const
+// (key, snapshot) sorts in front of all older versions of key
+{
+    const auto position =
+        list.lower_bound(internal_key_type{key, snapshot, Entry_kind::value});
+
+    if (position == list.end() || !(position->first.user_key == key)) {
+        return Lookup::missing;
+    }
+    if (position->first.kind == Entry_kind::tombstone) {
+        return Lookup::deleted;
+    }
+
+    value = position->second;
+    return Lookup::found;
+}
+
+template <typename Key, typename T, typename Size>
+template <typename Codec>
+std::uint64_t Memtable<Key, T, Size>::flush(std::ostream& out,
+                                            std::size_t block_size,
+                                            Codec codec) const
+// a block is written as soon as it reaches block_size, so the memory needed
+// does not grow with the table. only the index is kept until the end
+{
+    assert(is_frozen);
+
+    auto offset = std::uint64_t{};
+    auto block = std::string{};
+    auto index = std::string{};
+    auto last_key = std::string{};
+    auto scratch = std::string{};
+
+    const auto write_block = [&] {
+        put_varint(last_key.size(), index);
+        index += last_key;
+        put_varint(offset, index);
+        put_varint(block.size(), index);
+
+        out.write(block.data(), static_cast<std::streamsize>(block.size()));
+        offset += block.size();
+        block.clear();
+    };
+
+    for (const auto& [key, value] : list) {
+        last_key.clear();
+        codec(key.user_key, last_key);
+        put_varint(last_key.size(), block);
+        block += last_key;
+
+        const auto tombstone = key.kind == Entry_kind::tombstone;
+        put_varint(key.sequence << 1 | (tombstone ? 1 : 0), block);
+
+        scratch.clear();
+        if (!tombstone) {
+            codec(value, scratch);
+        }
+        put_varint(scratch.size(), block);
+        block += scratch;
+
+        if (block.size() >= block_size) {
+            write_block();
+        }
+    }
+
+    if (!block.empty()) {
+        write_block();
+    }
+
+    auto footer = std::string{};
+    put_fixed64(offset, footer);
+    put_fixed64(index.size(), footer);
+    put_fixed64(entry_count, footer);
+    put_fixed64(run_magic, footer);
+
+    out.write(index.data(), static_cast<std::streamsize>(index.size()));
+    out.write(footer.data(), static_cast<std::streamsize>(footer.size()));
+    return offset + index.size() + footer.size();
+}
+
+template <typename Key, typename T, typename Size>
+void Memtable<Key, T, Size>::put_varint(std::uint64_t value, std::string& out)
+// 7 bits per byte, low bits first, the high bit marks a following byte
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+template <typename Key, typename T, typename Size>
+void Memtable<Key, T, Size>::put_fixed64(std::uint64_t value, std::string& out)
+{
+    for (auto i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+} // namespace skip_list
+#endif
@@ -0,0 +1,230 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm> // std::for_each, std::max
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>   // std::size_t
+#include <deque>     // queued jobs
+#include <exception> // std::exception_ptr
+#include <functional> // std::function
+#include <mutex>
+#include <optional> // partial results
+#include <thread>
+#include <utility> // std::move
+#include <vector>  // workers, bounds
+
+namespace skip_list {
+
+// fixed set of worker threads for the parallel algorithms below. run() hands
+// out the indices of a job to the workers and the calling thread, so a pool
+// of hardware_concurrency() - 1 workers keeps every core busy.
+//
+// run() must not be called from inside a job of the same pool, the caller
+// would wait for helpers queued behind itself.
+class Thread_pool {
+public:
+    explicit Thread_pool(std::size_t threads = default_threads())
+    {
+        workers.reserve(threads);
+        for (auto i = std::size_t{}; i < threads; ++i) {
+            workers.emplace_back([this] { work(); });
+        }
+    }
+
+    ~Thread_pool()
+    {
+        {
+            const auto lock = std::lock_guard<std::mutex>{mutex};
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    Thread_pool(const Thread_pool&) = delete;
+    Thread_pool& operator=(const Thread_pool&) = delete;
+
+    std::size_t size() const noexcept
+    {
+        return workers.size();
+    }
+
+    // calls job(i) for every i < count and returns when all calls are done.
+    // if a call throws, the indices not started yet are skipped and the
+    // first exception is rethrown here
+    template <typename Function> void run(std::size_t count, Function job);
+
+    // shared by all callers which don't bring their own pool
+    static Thread_pool& instance()
+    {
+        static auto pool = Thread_pool{};
+        return pool;
+    }
+
+private:
+    static std::size_t default_threads() noexcept
+    {
+        return std::max(std::thread::hardware_concurrency(), 1u) - 1;
+    }
+
+    void post(std::function<void()> job)
+    {
+        {
+            const auto lock = std::lock_guard<std::mutex>{mutex};
+            jobs.push_back(std::move(job));
+        }
+        wake.notify_one();
+    }
+
+    void work()
+    {
+        auto lock = std::unique_lock<std::mutex>{mutex};
+
+        for (;;) {
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+
+            if (jobs.empty()) { // stopping and nothing left
+                return;
+            }
+
+            auto job = std::move(jobs.front());
+            jobs.pop_front();
+
+            lock.unlock();
+            job();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> jobs;
+    bool stopping = false;
+
+    std::vector<std::thread> workers; // last, they start in the constructor
+};
+
+template <typename Function>
+void Thread_pool::run(std::size_t count, Function job)
+// the helpers take indices until none are left. the state lives on this
+// stack frame, run() only returns after every helper has signed off
+{
+    struct State {
+        std::atomic<std::size_t> next{0};
+        std::size_t finished = 0;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    auto state = State{};
+
+    const auto take_indices = [&] {
+        for (auto i = state.next++; i < count; i = state.next++) {
+            try {
+                job(i);
+            }
+            catch (...) {
+                const auto lock = std::lock_guard<std::mutex>{state.mutex};
+                if (!state.error) {
+                    state.error = std::current_exception();
+                }
+                state.next = count;
+            }
+        }
+    };
+
+    const auto helpers = std::min(count > 0 ? count - 1 : 0, size());
+    for (auto i = std::size_t{}; i < helpers; ++i) {
+        post([&] {
+            take_indices();
+            // notified under the lock, the caller may return right after
+            const auto lock = std::lock_guard<std::mutex>{state.mutex};
+            ++state.finished;
+            state.done.notify_one();
+        });
+    }
+
+    take_indices();
+
+    auto lock = std::unique_lock<std::mutex>{state.mutex};
+    state.done.wait(lock, [&] { return state.finished == helpers; });
+
+    if (state.error) {
+        std::rethrow_exception(state.error);
+    }
+}
+
+// where the parallel algorithms run: the pool, nullptr for
+// Thread_pool::instance(), and into how many ranges the list is cut, 0 for
+// four per thread so a slow range does not hold up the others
+struct Parallel_policy {
+    Thread_pool* pool = nullptr;
+    std::size_t ranges = 0;
+};
+
+namespace detail {
+inline Thread_pool& pool_of(const Parallel_policy& policy)
+{
+    return policy.pool ? *policy.pool : Thread_pool::instance();
+}
+
+inline std::size_t ranges_of(const Parallel_policy& policy, Thread_pool& pool)
+{
+    return policy.ranges ? policy.ranges : 4 * (pool.size() + 1);
+}
+} // namespace detail
+
+// calls function on every element of list, the ranges of list.partition()
+// at the same time. function has to be safe to call from several threads
+// for different elements. the list must not be modified meanwhile
+template <typename List, typename Function>
+void parallel_for_each(const Parallel_policy& policy, List& list,
+                       Function function)
+{
+    auto& pool = detail::pool_of(policy);
+    const auto bounds = list.partition(detail::ranges_of(policy, pool));
+    if (bounds.empty()) {
+        return;
+    }
+
+    pool.run(bounds.size() - 1, [&](std::size_t i) {
+        std::for_each(bounds[i], bounds[i + 1], function);
+    });
+}
+
+// reduce(init, transform(element)) over all elements like
+// std::transform_reduce. the ranges are reduced in parallel and the partial
+// results in key order afterwards, so reduce has to be associative but not
+// commutative
+template <typename List, typename U, typename Reduce, typename Transform>
+U parallel_reduce(const Parallel_policy& policy, const List& list, U init,
+                  Reduce reduce, Transform transform)
+{
+    auto& pool = detail::pool_of(policy);
+    const auto bounds = list.partition(detail::ranges_of(policy, pool));
+    if (bounds.empty()) {
+        return init;
+    }
+
+    // the ranges are not empty, each starts with its first element
+    auto partials = std::vector<std::optional<U>>(bounds.size() - 1);
+    pool.run(partials.size(), [&](std::size_t i) {
+        auto it = bounds[i];
+        auto partial = U(transform(*it));
+        for (++it; it != bounds[i + 1]; ++it) {
+            partial = reduce(std::move(partial), transform(*it));
+        }
+        partials[i] = std::move(partial);
+    });
+
+    for (auto& partial : partials) {
+        init = reduce(std::move(init), std::move(*partial));
+    }
+    return init;
+}
+
+} // namespace skip_list
+#endif
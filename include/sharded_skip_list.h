@@ -0,0 +1,606 @@
+#ifndef SHARDED_SKIP_LIST_H
+#define SHARDED_SKIP_LIST_H
+
+#include "skip_list.h"
+
+#include <algorithm> // std::upper_bound
+#include <atomic>    // lock state and routing table pointer
+#include <cstdint>   // std::uint64_t
+#include <functional> // std::hash of the thread id
+#include <memory>    // std::unique_ptr
+#include <mutex>     // std::unique_lock, std::mutex
+#include <optional>  // result of get()
+#include <shared_mutex> // std::shared_lock
+#include <thread>       // std::this_thread::yield
+#include <vector>       // boundaries and locks
+
+namespace skip_list {
+
+// reader-writer spinlock satisfying the SharedMutex requirements
+// state is -1 while a writer holds the lock, otherwise the count of readers
+class Rw_spinlock {
+public:
+    void lock() noexcept
+    {
+        auto expected = 0;
+        while (!state.compare_exchange_weak(expected, -1,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+            expected = 0;
+            std::this_thread::yield();
+        }
+    }
+
+    bool try_lock() noexcept
+    {
+        auto expected = 0;
+        return state.compare_exchange_strong(expected, -1,
+                                             std::memory_order_acquire,
+                                             std::memory_order_relaxed);
+    }
+
+    void unlock() noexcept
+    {
+        state.store(0, std::memory_order_release);
+    }
+
+    void lock_shared() noexcept
+    {
+        while (!try_lock_shared()) {
+            std::this_thread::yield();
+        }
+    }
+
+    bool try_lock_shared() noexcept
+    {
+        auto readers = state.load(std::memory_order_relaxed);
+        return readers >= 0 &&
+               state.compare_exchange_weak(readers, readers + 1,
+                                           std::memory_order_acquire,
+                                           std::memory_order_relaxed);
+    }
+
+    void unlock_shared() noexcept
+    {
+        state.fetch_sub(1, std::memory_order_release);
+    }
+
+private:
+    std::atomic<int> state{0};
+};
+
+// partitions the key space into ranges. every range is owned by one Skip_list
+// shard behind its own lock so writers on different ranges never contend.
+//
+// the range boundaries live in an immutable routing table. rebalance()
+// publishes a new table while holding every shard lock and stamps each shard
+// with the new version. an operation which routed with an outdated table sees
+// the version mismatch after locking its shard and routes again. a reader
+// only looks at a table while it is counted in one of the reader slots, an
+// old table is freed by the first publish which finds no reader counted.
+//
+// the boundaries follow the load: every rebalance_check_interval inserts or
+// erases of a shard, the shard sizes are compared and rebalance() runs if
+// the biggest shard holds more than the auto rebalance limit times its fair
+// share, see set_auto_rebalance(). rebalancing moves every node, the
+// interval and the limit keep it rare.
+template <typename Key, typename T> class Sharded_skip_list {
+public:
+    using list_type = Skip_list<Key, T>;
+    using key_type = typename list_type::key_type;
+    using mapped_type = typename list_type::mapped_type;
+    using value_type = typename list_type::value_type;
+    using size_type = typename list_type::size_type;
+
+    explicit Sharded_skip_list(size_type shard_count = 16);
+    explicit Sharded_skip_list(std::vector<key_type> boundaries);
+
+    Sharded_skip_list(const Sharded_skip_list&) = delete;
+    Sharded_skip_list& operator=(const Sharded_skip_list&) = delete;
+
+    bool insert(const value_type& value);
+    size_type erase(const key_type& key);
+
+    std::optional<value_type> extract_min(bool relaxed = false);
+
+    std::optional<mapped_type> get(const key_type& key) const;
+
+    size_type count(const key_type& key) const
+    {
+        auto lock = std::shared_lock<Rw_spinlock>{};
+        return acquire(key, lock).list.count(key);
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    size_type size() const; // count of nodes over all shards
+
+    size_type shard_count() const noexcept
+    {
+        return shards_size;
+    }
+
+    // count of nodes in shard index, read without locking
+    size_type shard_size(size_type index) const noexcept
+    {
+        return shards[index].count.load(std::memory_order_relaxed);
+    }
+
+    // visits all elements in key order. function runs while the shards are
+    // locked, so it must not call back into this container: an insert,
+    // erase, extract_min or rebalance from it deadlocks
+    template <typename Function> void for_each(Function function) const;
+
+    // visits all elements with lo <= key < hi in key order, with the same
+    // restriction on function as for_each
+    template <typename Function>
+    void for_each_in_range(const key_type& lo, const key_type& hi,
+                           Function function) const;
+
+    bool rebalance(double max_imbalance = 2.0);
+
+    // the imbalance at which inserts and erases call rebalance() themselves,
+    // 0 turns that off. 2 by default
+    void set_auto_rebalance(double max_imbalance) noexcept
+    {
+        auto_imbalance.store(max_imbalance, std::memory_order_relaxed);
+    }
+
+    static constexpr size_type rebalance_check_interval = 256;
+
+private:
+    struct Routing {
+        std::vector<key_type> boundaries; // first key of shard i + 1
+        std::uint64_t version;
+    };
+
+    struct alignas(64) Shard { // own cache line against false sharing
+        mutable Rw_spinlock lock;
+        std::uint64_t version = 0;
+        list_type list;
+        // written under the lock, read without it to decide on a rebalance
+        std::atomic<size_type> count{0};
+    };
+
+    struct alignas(64) Reader_slot {
+        std::atomic<size_type> readers{0};
+    };
+
+    // counts a reader of the routing table in the slot of its thread for
+    // its lifetime. the slots spread the counting over cache lines
+    class Routing_reader {
+    public:
+        explicit Routing_reader(const Sharded_skip_list& list)
+            : slot{list.reader_slots[slot_index()]}
+        {
+            slot.readers.fetch_add(1);
+            table = list.routing.load();
+        }
+
+        ~Routing_reader()
+        {
+            slot.readers.fetch_sub(1);
+        }
+
+        Routing_reader(const Routing_reader&) = delete;
+        Routing_reader& operator=(const Routing_reader&) = delete;
+
+        const Routing& operator*() const noexcept
+        {
+            return *table;
+        }
+
+        const Routing* operator->() const noexcept
+        {
+            return table;
+        }
+
+    private:
+        static size_type slot_index() noexcept
+        {
+            thread_local const auto index =
+                std::hash<std::thread::id>{}(std::this_thread::get_id()) %
+                reader_slot_count;
+            return index;
+        }
+
+        Reader_slot& slot;
+        const Routing* table;
+    };
+
+    static constexpr size_type reader_slot_count = 16;
+
+    static size_type route(const Routing& routing, const key_type& key);
+
+    template <typename Lock>
+    Shard& acquire(const key_type& key, Lock& lock) const;
+
+    template <typename Function>
+    void for_each_in_shards(const key_type* lo, const key_type* hi,
+                            Function function) const;
+
+    void publish(std::vector<key_type> boundaries);
+    void free_retired_routings();
+
+    void rebalance_if_due(size_type count);
+
+    size_type shards_size;
+    std::unique_ptr<Shard[]> shards;
+
+    std::atomic<const Routing*> routing{nullptr};
+    std::vector<std::unique_ptr<Routing>> routings; // retired and current
+    mutable Reader_slot reader_slots[reader_slot_count];
+    std::mutex rebalance_mutex;
+    std::atomic<double> auto_imbalance{2.0};
+};
+
+template <typename Key, typename T>
+Sharded_skip_list<Key, T>::Sharded_skip_list(size_type shard_count)
+    // without boundaries everything goes to the first shard until rebalance()
+    // spreads the keys
+    : shards_size{std::max(shard_count, size_type{1})},
+      shards{std::make_unique<Shard[]>(shards_size)}
+{
+    publish({});
+}
+
+template <typename Key, typename T>
+Sharded_skip_list<Key, T>::Sharded_skip_list(std::vector<key_type> boundaries)
+    // precondition: boundaries are sorted and unique
+    : shards_size{boundaries.size() + 1},
+      shards{std::make_unique<Shard[]>(shards_size)}
+{
+    publish(std::move(boundaries));
+}
+
+template <typename Key, typename T>
+bool Sharded_skip_list<Key, T>::insert(const value_type& value)
+{
+    auto lock = std::unique_lock<Rw_spinlock>{};
+    auto& shard = acquire(value.first, lock);
+
+    // a present key only gets the new value, the shard does not grow
+    const auto present = shard.list.find(value.first);
+    if (present != shard.list.end()) {
+        present->second = value.second;
+        return true;
+    }
+
+    if (!shard.list.insert(value).second) {
+        return false;
+    }
+    const auto count = shard.count.fetch_add(1, std::memory_order_relaxed) + 1;
+    lock.unlock();
+
+    rebalance_if_due(count);
+    return true;
+}
+
+template <typename Key, typename T>
+typename Sharded_skip_list<Key, T>::size_type
+Sharded_skip_list<Key, T>::erase(const key_type& key)
+{
+    auto lock = std::unique_lock<Rw_spinlock>{};
+    auto& shard = acquire(key, lock);
+
+    if (shard.list.erase(key) == 0) {
+        return 0;
+    }
+    const auto count = shard.count.fetch_sub(1, std::memory_order_relaxed) - 1;
+    lock.unlock();
+
+    rebalance_if_due(count);
+    return 1;
+}
+
+template <typename Key, typename T>
+std::optional<typename Sharded_skip_list<Key, T>::value_type>
+Sharded_skip_list<Key, T>::extract_min(bool relaxed)
+// removes the smallest element of the first non empty shard. the shards are
+// visited in key order. if a rebalance moved keys during the walk it starts
+// over, a concurrent insert into an already visited shard is not seen.
+//
+// relaxed skips shards which are locked by someone else, so concurrent
+// callers spread over the lowest non empty shards instead of queuing on the
+// same lock. the result is then only close to the minimum.
+{
+    for (;;) {
+        const auto version = Routing_reader{*this}->version;
+        auto skipped = false;
+
+        for (auto i = size_type{}; i < shards_size; ++i) {
+            auto lock = std::unique_lock<Rw_spinlock>{shards[i].lock,
+                                                      std::defer_lock};
+            if (relaxed) {
+                if (!lock.try_lock()) {
+                    skipped = true;
+                    continue;
+                }
+            }
+            else {
+                lock.lock();
+            }
+
+            if (shards[i].version != version) {
+                break;
+            }
+            if (!shards[i].list.empty()) {
+                shards[i].count.fetch_sub(1, std::memory_order_relaxed);
+                return shards[i].list.extract_min();
+            }
+        }
+
+        if (Routing_reader{*this}->version == version) {
+            if (!skipped) {
+                return std::nullopt; // every shard was seen empty
+            }
+            relaxed = false; // everything free was empty, wait for the rest
+        }
+    }
+}
+
+template <typename Key, typename T>
+std::optional<typename Sharded_skip_list<Key, T>::mapped_type>
+Sharded_skip_list<Key, T>::get(const key_type& key) const
+// returns a copy because the node can be erased as soon as the lock is gone
+{
+    auto lock = std::shared_lock<Rw_spinlock>{};
+    const auto& list = std::as_const(acquire(key, lock).list);
+
+    const auto it = list.find(key);
+    if (it == list.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+template <typename Key, typename T>
+typename Sharded_skip_list<Key, T>::size_type
+Sharded_skip_list<Key, T>::size() const
+{
+    auto counter = size_type{};
+    for_each_in_shards(nullptr, nullptr, [&](const auto&) { ++counter; });
+    return counter;
+}
+
+template <typename Key, typename T>
+template <typename Function>
+void Sharded_skip_list<Key, T>::for_each(Function function) const
+{
+    for_each_in_shards(nullptr, nullptr, function);
+}
+
+template <typename Key, typename T>
+template <typename Function>
+void Sharded_skip_list<Key, T>::for_each_in_range(const key_type& lo,
+                                                  const key_type& hi,
+                                                  Function function) const
+{
+    if (lo > hi) {
+        return;
+    }
+    for_each_in_shards(&lo, &hi, function);
+}
+
+template <typename Key, typename T>
+bool Sharded_skip_list<Key, T>::rebalance(double max_imbalance)
+// if the biggest shard holds more than max_imbalance times its fair share,
+// the keys are redistributed so every shard holds about the same count.
+// returns true if the boundaries were changed
+{
+    auto guard = std::lock_guard<std::mutex>{rebalance_mutex};
+
+    // always lock in index order, same as the range scans, to avoid deadlocks
+    auto locks = std::vector<std::unique_lock<Rw_spinlock>>{};
+    locks.reserve(shards_size);
+    for (auto i = size_type{}; i < shards_size; ++i) {
+        locks.emplace_back(shards[i].lock);
+    }
+
+    auto total = size_type{};
+    auto biggest = size_type{};
+    for (auto i = size_type{}; i < shards_size; ++i) {
+        const auto count = shards[i].count.load(std::memory_order_relaxed);
+        total += count;
+        biggest = std::max(biggest, count);
+    }
+
+    const auto fair_share = static_cast<double>(total) / shards_size;
+
+    if (total < shards_size || biggest <= max_imbalance * fair_share) {
+        return false;
+    }
+
+    // shards hold disjoint ascending ranges so walking them in order yields
+    // all keys sorted. every total / shards_size key starts a new shard
+    auto boundaries = std::vector<key_type>{};
+    boundaries.reserve(shards_size - 1);
+
+    auto position = size_type{};
+    for (auto i = size_type{}; i < shards_size; ++i) {
+        for (const auto& value : shards[i].list) {
+            if (position != 0 && boundaries.size() < shards_size - 1 &&
+                position == (boundaries.size() + 1) * total / shards_size) {
+                boundaries.push_back(value.first);
+            }
+            ++position;
+        }
+    }
+
+    // the nodes are handed over as they are, nothing is reallocated
+    auto lists = std::vector<list_type>(shards_size);
+    auto counts = std::vector<size_type>(shards_size);
+    auto target = size_type{};
+    for (auto i = size_type{}; i < shards_size; ++i) {
+        auto& list = shards[i].list;
+
+        while (!list.empty()) {
+            auto node = list.extract(list.cbegin());
+            while (target < boundaries.size() &&
+                   !(boundaries[target] > node.key())) {
+                ++target;
+            }
+            lists[target].insert(std::move(node));
+            ++counts[target];
+        }
+    }
+
+    for (auto i = size_type{}; i < shards_size; ++i) {
+        swap(shards[i].list, lists[i]);
+        shards[i].count.store(counts[i], std::memory_order_relaxed);
+    }
+
+    publish(std::move(boundaries));
+    return true;
+}
+
+template <typename Key, typename T>
+void Sharded_skip_list<Key, T>::rebalance_if_due(size_type count)
+// count is the size of the shard just changed. the sizes are read without
+// locks, rebalance() checks them again under the locks
+{
+    const auto max_imbalance = auto_imbalance.load(std::memory_order_relaxed);
+    if (max_imbalance <= 0 || count % rebalance_check_interval != 0) {
+        return;
+    }
+
+    auto total = size_type{};
+    auto biggest = size_type{};
+    for (auto i = size_type{}; i < shards_size; ++i) {
+        const auto shard_count =
+            shards[i].count.load(std::memory_order_relaxed);
+        total += shard_count;
+        biggest = std::max(biggest, shard_count);
+    }
+
+    if (biggest > max_imbalance * total / shards_size) {
+        rebalance(max_imbalance);
+    }
+}
+
+template <typename Key, typename T>
+typename Sharded_skip_list<Key, T>::size_type
+Sharded_skip_list<Key, T>::route(const Routing& routing, const key_type& key)
+// index of the shard whose range contains key
+{
+    const auto& boundaries = routing.boundaries;
+
+    const auto it = std::upper_bound(
+        std::begin(boundaries), std::end(boundaries), key,
+        [](const key_type& a, const key_type& b) { return b > a; });
+
+    return static_cast<size_type>(it - std::begin(boundaries));
+}
+
+template <typename Key, typename T>
+template <typename Lock>
+typename Sharded_skip_list<Key, T>::Shard&
+Sharded_skip_list<Key, T>::acquire(const key_type& key, Lock& lock) const
+// locks the shard owning key. retries if a rebalance moved the boundaries
+// between reading the routing table and taking the lock
+{
+    for (;;) {
+        auto index = size_type{};
+        auto version = std::uint64_t{};
+        {
+            const auto table = Routing_reader{*this};
+            index = route(*table, key);
+            version = table->version;
+        }
+
+        auto& shard = shards[index];
+
+        lock = Lock{shard.lock};
+        if (shard.version == version) {
+            return shard;
+        }
+        lock.unlock();
+    }
+}
+
+template <typename Key, typename T>
+template <typename Function>
+void Sharded_skip_list<Key, T>::for_each_in_shards(const key_type* lo,
+                                                   const key_type* hi,
+                                                   Function function) const
+// all shards overlapping [lo, hi) are locked at once so the scan sees one
+// consistent cut even if a rebalance runs concurrently. nullptr means
+// unbounded
+{
+    auto locks = std::vector<std::shared_lock<Rw_spinlock>>{};
+
+    for (;;) {
+        auto first = size_type{};
+        auto last = shards_size - 1;
+        auto version = std::uint64_t{};
+        {
+            const auto table = Routing_reader{*this};
+            first = lo ? route(*table, *lo) : first;
+            last = hi ? route(*table, *hi) : last;
+            version = table->version;
+        }
+
+        auto consistent = true;
+        for (auto i = first; i <= last; ++i) {
+            locks.emplace_back(shards[i].lock);
+            if (shards[i].version != version) {
+                consistent = false;
+                break;
+            }
+        }
+
+        if (consistent) {
+            for (auto i = first; i <= last; ++i) {
+                const auto& list = std::as_const(shards[i].list);
+
+                auto it = lo ? list.lower_bound(*lo) : list.begin();
+                for (; it != list.end(); ++it) {
+                    if (hi && !(*hi > it->first)) {
+                        return;
+                    }
+                    function(*it);
+                }
+            }
+            return;
+        }
+        locks.clear();
+    }
+}
+
+template <typename Key, typename T>
+void Sharded_skip_list<Key, T>::publish(std::vector<key_type> boundaries)
+// precondition: caller holds all shard locks or is the constructor
+{
+    const auto version = routings.empty() ? 0 : routings.back()->version + 1;
+
+    routings.push_back(
+        std::make_unique<Routing>(Routing{std::move(boundaries), version}));
+
+    for (auto i = size_type{}; i < shards_size; ++i) {
+        shards[i].version = version;
+    }
+    routing.store(routings.back().get());
+    free_retired_routings();
+}
+
+template <typename Key, typename T>
+void Sharded_skip_list<Key, T>::free_retired_routings()
+// a reader is counted before it loads the table. the counter and the table
+// pointer are sequentially consistent: a reader counted after a slot was
+// read here loads the table published before. if every slot reads 0 no
+// reader can hold a retired table any more, otherwise the next publish
+// tries again
+{
+    for (const auto& slot : reader_slots) {
+        if (slot.readers.load() != 0) {
+            return;
+        }
+    }
+    routings.erase(std::begin(routings), std::end(routings) - 1);
+}
+
+} // namespace skip_list
+#endif
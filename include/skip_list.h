@@ -1,10 +1,16 @@
 #ifndef SKIP_LIST_H
 #define SKIP_LIST_H
 
+#include "skip_list_detail.h"
+
 #include <algorithm> // std::foreach
+#include <array>     // for fixed head implementation
 #include <cassert>
+#include <cstdint>     // std::uintptr_t
 #include <cstdlib>     // aligned_alloc() and free()
+#include <cstring>     // std::memcpy
 #include <iterator>    // begin() and end()
+#include <new>         // placement new, std::bad_alloc
 #include <ostream>     // std::ostream
 #include <random>      // generation of the levels
 #include <type_traits> // conditional
@@ -13,110 +19,231 @@
 
 namespace skip_list {
 
-template <typename Key, typename T> class Skip_list {
+// default node storage of Skip_list. a storage type has static allocate and
+// deallocate functions, so the nodes don't need to know their list. the size
+// and alignment passed to deallocate are the ones passed to allocate.
+//
+// allocate_sequence is used where many nodes are created in key order, by
+// copying and by compact. out[i] gets sizes[i] bytes, each can be passed to
+// deallocate on its own. a storage should hand them out in increasing
+// address order, ideally back to back, and can serve them in one go. throws
+// std::bad_alloc and keeps nothing if not all of them can be allocated.
+// sequence_length is the count of nodes a copy asks for at once. the heap
+// can only be asked for each node, allocating ahead of the copying just
+// costs cache misses there. so copies on the heap still allocate node by
+// node, only a storage with a longer sequence gets the batches
+struct Heap_storage {
+    static constexpr std::size_t sequence_length = 1;
+
+    static void* allocate(std::size_t size, std::size_t alignment)
+    {
+        return std::aligned_alloc(alignment, size);
+    }
+
+    static void allocate_sequence(std::size_t count, const std::size_t* sizes,
+                                  std::size_t alignment, void** out)
+    {
+        for (auto i = std::size_t{}; i < count; ++i) {
+            out[i] = allocate(sizes[i], alignment);
+
+            if (out[i] == nullptr) {
+                while (i > 0) {
+                    --i;
+                    deallocate(out[i], sizes[i], alignment);
+                }
+                throw std::bad_alloc{};
+            }
+        }
+    }
+
+    static void deallocate(void* p, std::size_t, std::size_t) noexcept
+    {
+        std::free(p);
+    }
+};
+
+// head of a Skip_list with a compile time MaxLevel. same interface as the
+// std::vector used otherwise but the links are stored inline, so an empty list
+// does not allocate
+template <typename Link, std::size_t Capacity> class Fixed_head {
+public:
+    using size_type = std::size_t;
+
+    Fixed_head(size_type count, Link link) noexcept
+    {
+        assign(count, link);
+    }
+
+    size_type size() const noexcept
+    {
+        return count;
+    }
+
+    Link* data() noexcept
+    {
+        return links.data();
+    }
+    const Link* data() const noexcept
+    {
+        return links.data();
+    }
+
+    Link& operator[](size_type index) noexcept
+    {
+        return links[index];
+    }
+    const Link& operator[](size_type index) const noexcept
+    {
+        return links[index];
+    }
+
+    Link& back() noexcept
+    {
+        return links[count - 1];
+    }
+
+    Link* begin() noexcept
+    {
+        return links.data();
+    }
+    Link* end() noexcept
+    {
+        return links.data() + count;
+    }
+
+    void push_back(Link link) noexcept
+    {
+        assert(count < Capacity);
+        links[count++] = link;
+    }
+
+    void pop_back() noexcept
+    {
+        --count;
+    }
+
+    void assign(size_type new_count, Link link) noexcept
+    {
+        assert(new_count <= Capacity);
+        count = new_count;
+        std::fill(links.begin(), links.begin() + count, link);
+    }
+
+private:
+    std::array<Link, Capacity> links{};
+    size_type count = 0;
+};
+
+// Multi allows several elements with the same key. they are kept in insertion
+// order. see Skip_multimap
+//
+// with T = void only keys are stored, the nodes have no mapped value at all.
+// see Skip_set
+//
+// MaxLevel > 0 caps the tower height at compile time. the head is then an
+// inline array instead of a std::vector, so an empty list does not allocate.
+// the searches still start at the current height of the list, which is
+// usually far below the cap. 0 lets the height grow with the list
+//
+// Storage provides the memory of the nodes, see Heap_storage for the
+// interface and huge_page_storage.h for a backend on huge pages
+template <typename Key, typename T, std::size_t MaxLevel = 0,
+          bool Multi = false, typename Storage = Heap_storage>
+class Skip_list {
 private:
     // forward declaration because iterator class needs to know about the node
     struct Skip_node;
     // element before first element containg pointers to all the first elements
     // of each level
-    std::vector<Skip_node*> head = std::vector<Skip_node*>(1, nullptr);
+    using Head = std::conditional_t<MaxLevel == 0, std::vector<Skip_node*>,
+                                    Fixed_head<Skip_node*, MaxLevel>>;
+    Head head = Head(1, nullptr);
 
 public:
     using key_type = Key;
     using mapped_type = T;
 
-    using value_type = std::pair<const key_type, mapped_type>;
+    using value_type =
+        std::conditional_t<std::is_void_v<mapped_type>, const key_type,
+                           std::pair<const key_type, mapped_type>>;
     using size_type = std::size_t;
 
 public:
-    template <typename it_value_type> class iterator_base {
+    template <typename it_value_type>
+    using iterator_base =
+        detail::Node_iterator<Skip_list, Skip_node, it_value_type>;
+
+    using iterator = iterator_base<value_type>;
+    using const_iterator = iterator_base<const value_type>;
+
+    // owns a node taken out of a list with extract(). the node keeps its
+    // tower so it can be put into another list with insert() without any
+    // allocation or copy of the value
+    class node_type {
     public:
-        using value_type = it_value_type;
-        using difference_type = std::ptrdiff_t;
-        using pointer = value_type*;
-        using reference = value_type&;
-        using iterator_category = std::forward_iterator_tag;
-        using node_type = std::conditional_t<std::is_const_v<value_type>,
-                                             const Skip_node, Skip_node>;
-
-        iterator_base() = default;
-
-        // the order is determinde by the key so compare by it
-        constexpr bool operator==(const iterator_base& b) const noexcept
-        {
-            return curr == b.curr;
-        }
-        constexpr bool operator!=(const iterator_base& b) const noexcept
-        {
-            return curr != b.curr;
-        }
+        using key_type = Key;
+        using mapped_type = T;
 
-        iterator_base& operator++() noexcept
-        {
-            assert(curr != nullptr);
+        node_type() = default;
 
-            curr = curr->next[0];
-            return *this;
+        ~node_type()
+        {
+            if (node) {
+                free_node(node);
+            }
         }
 
-        iterator_base operator++(int) noexcept
-        {
-            assert(curr != nullptr);
+        node_type(const node_type&) = delete;
+        node_type& operator=(const node_type&) = delete;
 
-            auto temp = *this;
-            operator++();
-            return temp;
+        node_type(node_type&& other) noexcept : node{other.node}
+        {
+            other.node = nullptr;
         }
 
-        constexpr iterator_base& operator+=(const int offset) noexcept
+        node_type& operator=(node_type&& other) noexcept
         {
-            if (offset <= 0) {
-                return *this;
-            }
-
-            for (int i = 0; i < offset; ++i) {
-                ++(*this);
-            }
+            using std::swap;
+            swap(node, other.node);
             return *this;
         }
 
-        constexpr iterator_base operator+(const int offset) noexcept
+        bool empty() const noexcept
         {
-            iterator_base it = *this;
-            it += offset;
-            return it;
+            return node == nullptr;
         }
 
-        constexpr value_type& operator*() noexcept
-        {
-            return curr->value;
-        }
-        constexpr value_type* operator->() noexcept
+        explicit operator bool() const noexcept
         {
-            return &curr->value;
+            return node != nullptr;
         }
 
-        constexpr const value_type& operator*() const noexcept
+        const key_type& key() const noexcept
         {
-            return curr->value;
+            return node->key();
         }
 
-        constexpr const value_type* operator->() const noexcept
+        auto& mapped() const noexcept
         {
-            return &curr->value;
+            static_assert(!std::is_void_v<mapped_type>, "a set has no mapped");
+            return node->value.second;
         }
 
     private:
-        explicit constexpr iterator_base(node_type* pos) noexcept
-            : curr{pos} {};
+        explicit node_type(Skip_node* pos) noexcept : node{pos}
+        {
+        }
 
-        node_type* curr = nullptr;
+        Skip_node* node = nullptr;
 
-        friend class Skip_list; // to access curr in skiplist functions
+        friend class Skip_list;
     };
 
-    using iterator = iterator_base<value_type>;
-    using const_iterator = iterator_base<const value_type>;
+    struct insert_return_type {
+        iterator position;
+        bool inserted;
+        node_type node;
+    };
 
     Skip_list() = default;
 
@@ -201,7 +328,7 @@ public:
 
     size_type size() const noexcept // return count of nodes
     {
-        Skip_list<Key, T>::size_type counter = Skip_list<Key, T>::size_type{};
+        Skip_list::size_type counter = Skip_list::size_type{};
 
         for (auto index = head[0]; index != nullptr;
              index = index->next[0], ++counter)
@@ -215,27 +342,67 @@ public:
         return std::numeric_limits<size_type>::max();
     }
 
-    mapped_type& operator[](const key_type& key)
+    // auto& so the declaration stays valid for sets
+    auto& operator[](const key_type& key)
     {
+        static_assert(!Multi, "operator[] is ambiguous with duplicate keys");
+        static_assert(!std::is_void_v<mapped_type>, "a set has no mapped");
         return find(key)->second;
     }
-    mapped_type& operator[](key_type&& key)
+    auto& operator[](key_type&& key)
     {
+        static_assert(!Multi, "operator[] is ambiguous with duplicate keys");
+        static_assert(!std::is_void_v<mapped_type>, "a set has no mapped");
         return find(key)->second;
     }
 
+    // with Multi the value is always inserted behind all elements with the
+    // same key and the bool is always true
     std::pair<iterator, bool> insert(const value_type& value);
 
     // todo:
     // std::pair<iterator, bool> insert(value_type&& value);
 
+    // like std::map: if the key is already present the node is not inserted
+    // and handed back in insert_return_type::node. with Multi it is always
+    // inserted
+    insert_return_type insert(node_type&& node);
+
+    // returns the count of removed elements, with Multi all with the key
     size_type erase(const key_type& key);
 
-    // todo:
-    // iterator erase(const_iterator const_iterator);
+    iterator erase(const_iterator position);
 
-    // todo:
-    // iterator erase(iterator iterator);
+    node_type extract(const key_type& key)
+    {
+        return node_type{unlink(key)};
+    }
+
+    node_type extract(const_iterator position)
+    // the first node can be unlinked without a search
+    {
+        if (position.curr == head[0]) {
+            return node_type{unlink_front()};
+        }
+        return node_type{unlink(position.curr)};
+    }
+
+    // removes the element with the smallest key in O(levels) without a search
+    // precondition: !empty()
+    void pop_front()
+    {
+        free_node(unlink_front());
+    }
+
+    value_type extract_min()
+    // same as pop_front but hands out the removed element
+    // precondition: !empty()
+    {
+        const auto node = unlink_front();
+        auto value = std::move(node->value);
+        free_node(node);
+        return value;
+    }
 
     void clear() noexcept
     {
@@ -246,9 +413,41 @@ public:
     iterator find(const key_type& key);
     const_iterator find(const key_type& key) const;
 
+    iterator lower_bound(const key_type& key);
+    const_iterator lower_bound(const key_type& key) const;
+
+    iterator upper_bound(const key_type& key);
+    const_iterator upper_bound(const key_type& key) const;
+
+    std::pair<iterator, iterator> equal_range(const key_type& key)
+    {
+        return std::make_pair(lower_bound(key), upper_bound(key));
+    }
+
+    std::pair<const_iterator, const_iterator>
+    equal_range(const key_type& key) const
+    {
+        return std::make_pair(lower_bound(key), upper_bound(key));
+    }
+
+    // looks up all keys in [first, last) and writes one iterator per key to
+    // out, end() if the key is not present. the lookups run interleaved so
+    // the cache misses of one overlap with the progress of the others
+    template <typename ForwardIt, typename OutputIt>
+    OutputIt find_many(ForwardIt first, ForwardIt last, OutputIt out);
+    template <typename ForwardIt, typename OutputIt>
+    OutputIt find_many(ForwardIt first, ForwardIt last, OutputIt out) const;
+
     size_type count(const key_type& key) const
     {
-        return find(key) != end() ? 1 : 0;
+        if constexpr (Multi) {
+            const auto range = equal_range(key);
+            return static_cast<size_type>(
+                std::distance(range.first, range.second));
+        }
+        else {
+            return find(key) != end() ? 1 : 0;
+        }
     }
 
     size_type top_level() const
@@ -256,22 +455,120 @@ public:
         return head.size();
     }
 
+    size_type level(const_iterator position) const noexcept
+    {
+        return position.curr->levels;
+    }
+
+    // rebuilds the tower of the element with the given height and returns
+    // its new position. reset_level draws a new random height instead
+    iterator set_level(const_iterator position, size_type levels);
+
+    iterator reset_level(const_iterator position)
+    {
+        return set_level(position, generate_level());
+    }
+
+    // moves up to budget nodes from position on into new memory in key
+    // order. returns where the next call continues, end() after the last
+    // node:
+    //
+    //     for (auto it = list.begin(); it != list.end();)
+    //         it = list.compact(it, 256); // e.g. one batch per idle slot
+    //
+    // the returned iterator stays valid between the calls like any other,
+    // unless its element is erased. iterators to the moved elements are
+    // invalidated.
+    //
+    // only a Storage whose allocate_sequence hands out the nodes back to
+    // back, like Huge_page_storage, makes the level 0 chain run through
+    // memory in address order again after insert / erase churn. Heap_storage
+    // takes every node from the heap, which fills the holes the churn left,
+    // so there compact moves the nodes without bringing them closer
+    iterator compact(const_iterator position, size_type budget);
+
+    // share of the level 0 links which point at most locality_distance bytes
+    // forward in memory. close to 1 for a list copied or compacted into a
+    // storage which allocates in sequence, drops towards 0 with churn. O(n)
+    double locality() const noexcept;
+
+    static constexpr std::size_t locality_distance = 4096;
+
+    // count of nodes find(key) compares against. for measuring the tower
+    // layout, e.g. of an adaptive list
+    size_type search_length(const key_type& key) const;
+
+    // cuts the list into at most n ranges of about the same length and
+    // returns their bounds: begin(), the first elements of ranges 2 to n and
+    // end(). the cuts are nodes of the highest level which holds at least
+    // partition_oversampling * n nodes, the gaps between them average out,
+    // so O(n + log size()) nodes are visited. fewer ranges for short lists,
+    // no bounds at all for an empty list
+    std::vector<const_iterator> partition(size_type n) const;
+    std::vector<iterator> partition(size_type n);
+
+    static constexpr size_type partition_oversampling = 16;
+
     void debug_print(
         std::ostream& os) const; // show all the levels for debug only. can this
                                  // be put into skiplist_unit_tests ?
 private:
-    size_type generate_level() const;
-    static bool next_level() noexcept;
+    size_type generate_level() const
+    {
+        return detail::generate_level(head.size(), MaxLevel);
+    }
+
+    // count of lookups find_many keeps in flight at the same time
+    static constexpr size_type find_many_group_size = 8;
+
+    template <typename ForwardIt, typename Visitor>
+    void find_group(ForwardIt first, ForwardIt last, Visitor visitor) const;
+
+    static void prefetch(const void* address) noexcept
+    {
+#if defined(__GNUC__)
+        __builtin_prefetch(address);
+#endif
+    }
+
+    static const key_type& key_of(const value_type& value) noexcept
+    {
+        if constexpr (std::is_void_v<mapped_type>) {
+            return value;
+        }
+        else {
+            return value.first;
+        }
+    }
 
     struct Skip_node {
-        value_type value; // key / T
+        value_type value; // key / T or only key for sets
         size_type levels;
         Skip_node* next[1];
+
+        const key_type& key() const noexcept
+        {
+            return key_of(value);
+        }
     };
 
+    size_type erase_all(const key_type& key);
+
+    void link(Skip_node* node);
+
+    Skip_node* unlink(const key_type& key);
+    Skip_node* unlink(const Skip_node* node) noexcept;
+    Skip_node* unlink_front() noexcept;
+
+    static constexpr size_type node_size(size_type levels) noexcept
+    {
+        return sizeof(Skip_node) + (levels - 1) * sizeof(Skip_node*);
+    }
+
     static Skip_node* allocate_node(value_type value, size_type levels);
     static void free_node(Skip_node* node);
 
+    static Skip_node* copy_node_to(void* memory, const Skip_node* node);
     void copy_nodes(const Skip_list& other);
     static void free_all_nodes(Skip_node* head) noexcept;
 
@@ -293,9 +590,10 @@ private:
     };
 };
 
-template <typename Key, typename T>
-std::pair<typename Skip_list<Key, T>::iterator, bool>
-Skip_list<Key, T>::insert(const value_type& value)
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+std::pair<typename Skip_list<Key, T, MaxLevel, Multi, Storage>::iterator, bool>
+Skip_list<Key, T, MaxLevel, Multi, Storage>::insert(const value_type& value)
 // if key is already present the position of that key is returned and false for
 // no insert
 //
@@ -303,6 +601,11 @@ Skip_list<Key, T>::insert(const value_type& value)
 // iterator and indicate change with true otherwise return iterator end() and
 // false
 {
+    if constexpr (Multi) {
+        auto result = insert(node_type{allocate_node(value, generate_level())});
+        return std::make_pair(result.position, true);
+    }
+
     const auto insert_level = generate_level(); // top level of new node
     const auto insert_node = allocate_node(value, insert_level);
     Skip_list::Skip_node* old_node = nullptr;
@@ -322,7 +625,7 @@ Skip_list<Key, T>::insert(const value_type& value)
         auto node = next[index];
 
         if (node == nullptr ||
-            node->value.first > value.first) { // compare by key
+            node->key() > key_of(value)) { // compare by key
 
             if (level <= insert_level) {
 
@@ -336,7 +639,7 @@ Skip_list<Key, T>::insert(const value_type& value)
             }
             --level;
         }
-        else if (node->value.first == value.first) {
+        else if (node->key() == key_of(value)) {
             // key already present, keep node with more levels
             //  -> no need to insert new node into list if not needed
             //  -> if insert_node->levels > node->levels, we already modified
@@ -346,7 +649,9 @@ Skip_list<Key, T>::insert(const value_type& value)
             //     insert_node have been made)
 
             if (node->levels >= insert_level) {
-                node->value.second = value.second;
+                if constexpr (!std::is_void_v<mapped_type>) {
+                    node->value.second = value.second;
+                }
                 free_node(insert_node);
 
                 return std::make_pair(Skip_list::iterator{node}, true);
@@ -370,18 +675,386 @@ Skip_list<Key, T>::insert(const value_type& value)
     return std::make_pair(insert_pos, added);
 }
 
-template <typename Key, typename T>
-typename Skip_list<Key, T>::size_type
-Skip_list<Key, T>::erase(const key_type& key)
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::size_type
+Skip_list<Key, T, MaxLevel, Multi, Storage>::erase(const key_type& key)
+// the return type indicates how many elements are deleted (like std::map)
+// it can become only 0 or 1 unless Multi is set
+{
+    if constexpr (Multi) {
+        return erase_all(key);
+    }
+
+    if (const auto node = unlink(key)) {
+        free_node(node);
+        return 1;
+    }
+    else {
+        return 0;
+    }
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::insert_return_type
+Skip_list<Key, T, MaxLevel, Multi, Storage>::insert(node_type&& node)
+// the node is linked with the levels it already has. a lookup is done first
+// so the list stays untouched if the key is already present
+{
+    if (node.empty()) {
+        return insert_return_type{end(), false, node_type{}};
+    }
+
+    const auto& key = node.key();
+
+    if constexpr (!Multi) {
+        if (const auto it = find(key); it != end()) {
+            return insert_return_type{it, false, std::move(node)};
+        }
+    }
+
+    const auto insert_node = node.node;
+    node.node = nullptr;
+
+    link(insert_node);
+    return insert_return_type{iterator{insert_node}, true, node_type{}};
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+void Skip_list<Key, T, MaxLevel, Multi, Storage>::link(Skip_node* node)
+// links the node on all of its levels behind every node with a smaller or
+// equal key
+{
+    const auto& key = node->key();
+
+    while (head.size() < node->levels) {
+        head.push_back(nullptr);
+    }
+
+    auto level = head.size();
+    auto next = head.data();
+
+    while (level > 0) {
+        const auto index = level - 1;
+
+        if (!next[index] || next[index]->key() > key) {
+            if (level <= node->levels) {
+                node->next[index] = next[index];
+                next[index] = node;
+            }
+            --level;
+        }
+        else {
+            next = next[index]->next;
+        }
+    }
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::iterator
+Skip_list<Key, T, MaxLevel, Multi, Storage>::set_level(const_iterator position,
+                                              size_type levels)
+// the tower size is fixed at allocation, so the node is rebuilt with the new
+// height. the new node is complete before the old one is unlinked and the
+// value is only moved if that can't throw, so if anything fails the list is
+// unchanged. the head grows first, relinking then can't allocate
+{
+    static_assert(!Multi, "relinking would change the order of duplicates");
+
+    levels = std::max(levels, size_type{1});
+    if constexpr (MaxLevel != 0) {
+        levels = std::min(levels, MaxLevel);
+    }
+
+    const auto node = const_cast<Skip_node*>(position.curr);
+    if (node->levels == levels) {
+        return iterator{node};
+    }
+
+    const auto size = node_size(levels);
+    const auto memory = Storage::allocate(size, alignof(Skip_node));
+    if (memory == nullptr) {
+        throw std::bad_alloc{};
+    }
+
+    Skip_node* new_node = nullptr;
+    try {
+        while (head.size() < levels) {
+            head.push_back(nullptr);
+        }
+        new_node = new (memory)
+            Skip_node{std::move_if_noexcept(node->value), levels, nullptr};
+    }
+    catch (...) {
+        Storage::deallocate(memory, size, alignof(Skip_node));
+        throw;
+    }
+
+    unlink(node);
+    free_node(node);
+    link(new_node);
+    return iterator{new_node};
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::iterator
+Skip_list<Key, T, MaxLevel, Multi, Storage>::compact(const_iterator position,
+                                                     size_type budget)
+// tail[i] is the link on level i which points to the next node to move or to
+// the first node behind it on that level, like in copy_nodes. all new nodes
+// of a batch are allocated before the old ones are freed, otherwise the heap
+// hands the memory of a freed node to the next one right away
+{
+    if (position.curr == nullptr || budget == 0) {
+        return iterator{const_cast<Skip_node*>(position.curr)};
+    }
+
+    const auto& key = position.curr->key();
+    auto tail = std::vector<Skip_node**>(head.size(), nullptr);
+
+    auto level = head.size();
+    auto next = head.data();
+
+    while (level > 0) {
+        const auto index = level - 1;
+
+        if (next[index] && key > next[index]->key()) {
+            next = next[index]->next;
+        }
+        else {
+            tail[index] = &next[index];
+            --level;
+        }
+    }
+
+    // with Multi elements with the same key can be in front of position
+    while (*tail[0] != position.curr) {
+        const auto node = *tail[0];
+        for (auto i = size_type{}; i < node->levels; ++i) {
+            tail[i] = &node->next[i];
+        }
+    }
+
+    auto moved = std::vector<Skip_node*>{};
+
+    for (auto node = *tail[0]; node != nullptr && moved.size() < budget;
+         node = node->next[0]) {
+        moved.push_back(node);
+    }
+
+    auto sizes = std::vector<std::size_t>{};
+    sizes.reserve(moved.size());
+    std::for_each(std::begin(moved), std::end(moved), [&](auto node) {
+        sizes.push_back(node_size(node->levels));
+    });
+
+    auto memory = std::vector<void*>(moved.size());
+    Storage::allocate_sequence(moved.size(), sizes.data(), alignof(Skip_node),
+                               memory.data());
+
+    // a value which can throw while moving is copied, so if a copy throws
+    // the replaced nodes still hold their values and the list is unchanged
+    auto index = size_type{};
+    try {
+        for (; index < moved.size(); ++index) {
+            const auto node = moved[index];
+            const auto copy = new (memory[index]) Skip_node{
+                std::move_if_noexcept(node->value), node->levels, nullptr};
+
+            for (auto i = size_type{}; i < copy->levels; ++i) {
+                copy->next[i] = node->next[i];
+                *tail[i] = copy;
+                tail[i] = &copy->next[i];
+            }
+        }
+    }
+    catch (...) {
+        for (auto unused = index; unused < moved.size(); ++unused) {
+            Storage::deallocate(memory[unused], sizes[unused],
+                                alignof(Skip_node));
+        }
+        std::for_each(std::begin(moved), std::begin(moved) + index,
+                      [](auto node) { free_node(node); });
+        throw;
+    }
+
+    std::for_each(std::begin(moved), std::end(moved),
+                  [](auto node) { free_node(node); });
+    return iterator{*tail[0]};
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+double Skip_list<Key, T, MaxLevel, Multi, Storage>::locality() const noexcept
+{
+    auto links = size_type{};
+    auto near_links = size_type{};
+
+    for (auto node = head[0]; node && node->next[0]; node = node->next[0]) {
+        const auto from = reinterpret_cast<std::uintptr_t>(node);
+        const auto to = reinterpret_cast<std::uintptr_t>(node->next[0]);
+
+        ++links;
+        near_links += to > from && to - from <= locality_distance;
+    }
+    return links == 0 ? 1.0 : static_cast<double>(near_links) / links;
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::size_type
+Skip_list<Key, T, MaxLevel, Multi, Storage>::search_length(
+    const key_type& key) const
+// same walk as find, but counts the nodes whose key is compared
+{
+    auto length = size_type{};
+
+    auto level = head.size();
+    auto next = head.data();
+
+    while (level > 0) {
+        const auto index = level - 1;
+
+        if (next[index]) {
+            ++length;
+        }
+
+        if (!next[index] || next[index]->key() > key) {
+            --level;
+        }
+        else if (next[index]->key() == key) {
+            break;
+        }
+        else {
+            next = next[index]->next;
+        }
+    }
+    return length;
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+std::vector<
+    typename Skip_list<Key, T, MaxLevel, Multi, Storage>::const_iterator>
+Skip_list<Key, T, MaxLevel, Multi, Storage>::partition(size_type n) const
+// a level holds about half the nodes of the one below, so the levels walked
+// above the chosen one add up to less than the chosen one itself
+{
+    auto bounds = std::vector<const_iterator>{};
+    if (head[0] == nullptr || n == 0) {
+        return bounds;
+    }
+
+    auto nodes = std::vector<const Skip_node*>{};
+    for (auto level = head.size(); level > 0; --level) {
+        nodes.clear();
+        for (auto node = head[level - 1]; node; node = node->next[level - 1]) {
+            nodes.push_back(node);
+        }
+        if (nodes.size() >= partition_oversampling * n) {
+            break;
+        }
+    }
+
+    bounds.push_back(begin());
+    for (auto i = size_type{1}; i < n; ++i) {
+        const auto cut = const_iterator{nodes[i * nodes.size() / n]};
+        if (cut != bounds.back()) {
+            bounds.push_back(cut);
+        }
+    }
+    bounds.push_back(end());
+    return bounds;
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+std::vector<typename Skip_list<Key, T, MaxLevel, Multi, Storage>::iterator>
+Skip_list<Key, T, MaxLevel, Multi, Storage>::partition(size_type n)
+{
+    const auto const_bounds = std::as_const(*this).partition(n);
+
+    auto bounds = std::vector<iterator>{};
+    bounds.reserve(const_bounds.size());
+    for (const auto bound : const_bounds) {
+        bounds.push_back(iterator{const_cast<Skip_node*>(bound.curr)});
+    }
+    return bounds;
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::iterator
+Skip_list<Key, T, MaxLevel, Multi, Storage>::erase(const_iterator position)
+// returns the iterator behind the removed element
+{
+    const auto next = position.curr->next[0];
+    free_node(unlink(position.curr));
+    return iterator{next};
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::size_type
+Skip_list<Key, T, MaxLevel, Multi, Storage>::erase_all(const key_type& key)
+// goes down in front of the first element with the key and on every level
+// links past all elements with the key. on the lowest level the removed run
+// is still chained through next[0] and gets freed
+{
+    auto removed = size_type{};
+
+    auto level = head.size();
+    auto next = head.data();
+
+    while (level > 0) {
+        const auto index = level - 1;
+
+        if (next[index] && key > next[index]->key()) {
+            next = next[index]->next;
+            continue;
+        }
+
+        const auto first = next[index];
+        while (next[index] && next[index]->key() == key) {
+            next[index] = next[index]->next[index];
+        }
+
+        if (index == 0) {
+            for (auto node = first; node != next[0];) {
+                const auto temp = node;
+                node = node->next[0];
+                free_node(temp);
+                ++removed;
+            }
+        }
+        --level;
+    }
+
+    while (head.size() > 1 && head.back() == nullptr)
+        head.pop_back();
+
+    return removed;
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::Skip_node*
+Skip_list<Key, T, MaxLevel, Multi, Storage>::unlink(const key_type& key)
 // starts search on the highest lvl of the Skip_list
-// if a node with the erase key is found the algorithm goes
+// if a node with the key is found the algorithm goes
 // down until the lowest lvl.
 // on the way down all links with the key in the list are removed
-// on the lowest lvl the current node which contains the erase key is deleted
-//
-// the return type indicates how many elements are deleted (like std::map)
-// it can become only 0 or 1
+// the node is returned to the caller, nullptr if the key was not found
 {
+    if constexpr (Multi) { // the first of the elements with the key
+        const auto first = lower_bound(key).curr;
+        return first && first->key() == key ? unlink(first) : nullptr;
+    }
+
     Skip_node* node = nullptr;
 
     auto level = head.size();
@@ -391,10 +1064,10 @@ Skip_list<Key, T>::erase(const key_type& key)
 
         const auto link_index = level - 1;
 
-        if (!next[link_index] || next[link_index]->value.first > key) {
+        if (!next[link_index] || next[link_index]->key() > key) {
             --level;
         }
-        else if (next[link_index]->value.first == key) {
+        else if (next[link_index]->key() == key) {
             node = next[link_index];
             next[link_index] = node->next[link_index];
             --level;
@@ -407,31 +1080,91 @@ Skip_list<Key, T>::erase(const key_type& key)
     while (head.size() > 1 && head.back() == nullptr)
         head.pop_back();
 
-    if (node) { // element to erase was found and taken out of list
-        free_node(node);
-        return 1;
+    return node;
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::Skip_node*
+Skip_list<Key, T, MaxLevel, Multi, Storage>::unlink(
+    const Skip_node* node) noexcept
+// unlinks exactly the given node even if there are others with the same key.
+// above its tower only the key decides the way. on its own levels the search
+// walks through the elements with the same key until it finds the node, all
+// of them are in front of it on the lower levels as well
+// precondition: node is part of this list
+{
+    const auto& key = node->key();
+
+    auto level = head.size();
+    auto next = head.data();
+
+    while (level > 0) {
+        const auto index = level - 1;
+
+        if (next[index] && key > next[index]->key()) {
+            next = next[index]->next;
+            continue;
+        }
+
+        if (level <= node->levels) {
+            while (next[index] != node) {
+                next = next[index]->next;
+            }
+            next[index] = node->next[index];
+        }
+        --level;
     }
-    else {
-        return 0;
+
+    while (head.size() > 1 && head.back() == nullptr)
+        head.pop_back();
+
+    return const_cast<Skip_node*>(node);
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::Skip_node*
+Skip_list<Key, T, MaxLevel, Multi, Storage>::unlink_front() noexcept
+// the first node is the first node on every level it is part of, so head is
+// its predecessor everywhere and it can be unlinked without searching
+{
+    assert(head[0] != nullptr);
+
+    const auto node = head[0];
+
+    for (auto i = size_type{}; i < node->levels; ++i) {
+        head[i] = node->next[i];
     }
+
+    while (head.size() > 1 && head.back() == nullptr)
+        head.pop_back();
+
+    return node;
 }
 
-template <typename Key, typename T>
-typename Skip_list<Key, T>::const_iterator
-Skip_list<Key, T>::find(const key_type& key) const
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::const_iterator
+Skip_list<Key, T, MaxLevel, Multi, Storage>::find(const key_type& key) const
 // first it is iterated horizontal and vertical until the last level is reached
 // on the last level if the keys match the iterator pointing to it is returned
 {
+    if constexpr (Multi) { // an early match could skip an older duplicate
+        const auto it = lower_bound(key);
+        return it != end() && key_of(*it) == key ? it : end();
+    }
+
     auto level = head.size();
     auto next = head.data();
 
     while (level > 0) {
         const auto index = level - 1;
 
-        if (!next[index] || next[index]->value.first > key) {
+        if (!next[index] || next[index]->key() > key) {
             --level;
         }
-        else if (next[index]->value.first == key) {
+        else if (next[index]->key() == key) {
             return const_iterator{next[index]};
         }
         else {
@@ -441,9 +1174,10 @@ Skip_list<Key, T>::find(const key_type& key) const
     return end();
 }
 
-template <typename Key, typename T>
-typename Skip_list<Key, T>::iterator
-Skip_list<Key, T>::find(const key_type& key)
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::iterator
+Skip_list<Key, T, MaxLevel, Multi, Storage>::find(const key_type& key)
 // same as const_iterator function, is there a way to not have this redundant?
 {
     auto const_it = std::as_const(*this).find(key);
@@ -451,8 +1185,181 @@ Skip_list<Key, T>::find(const key_type& key)
     return iterator{curr};
 }
 
-template <typename Key, typename T>
-void Skip_list<Key, T>::debug_print(std::ostream& os) const
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::const_iterator
+Skip_list<Key, T, MaxLevel, Multi, Storage>::lower_bound(
+    const key_type& key) const
+// same descent as find but instead of stopping on a match it always goes down
+// to the last level. the node after the last visited one is the first node
+// with a key not less than the given key
+{
+    auto level = head.size();
+    auto next = head.data();
+
+    while (level > 0) {
+        const auto index = level - 1;
+
+        if (!next[index] || !(key > next[index]->key())) {
+            --level;
+        }
+        else {
+            next = next[index]->next;
+        }
+    }
+    return const_iterator{next[0]};
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::iterator
+Skip_list<Key, T, MaxLevel, Multi, Storage>::lower_bound(const key_type& key)
+{
+    auto const_it = std::as_const(*this).lower_bound(key);
+    auto curr = const_cast<typename iterator::node_type*>(const_it.curr);
+    return iterator{curr};
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::const_iterator
+Skip_list<Key, T, MaxLevel, Multi, Storage>::upper_bound(
+    const key_type& key) const
+// like lower_bound but goes past nodes with an equal key as well
+{
+    auto level = head.size();
+    auto next = head.data();
+
+    while (level > 0) {
+        const auto index = level - 1;
+
+        if (!next[index] || next[index]->key() > key) {
+            --level;
+        }
+        else {
+            next = next[index]->next;
+        }
+    }
+    return const_iterator{next[0]};
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::iterator
+Skip_list<Key, T, MaxLevel, Multi, Storage>::upper_bound(const key_type& key)
+{
+    auto const_it = std::as_const(*this).upper_bound(key);
+    auto curr = const_cast<typename iterator::node_type*>(const_it.curr);
+    return iterator{curr};
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+template <typename ForwardIt, typename OutputIt>
+OutputIt
+Skip_list<Key, T, MaxLevel, Multi, Storage>::find_many(ForwardIt first,
+                                                       ForwardIt last,
+                                                       OutputIt out) const
+{
+    find_group(first, last, [&](const Skip_node* node) {
+        *out++ = const_iterator{node};
+    });
+    return out;
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+template <typename ForwardIt, typename OutputIt>
+OutputIt
+Skip_list<Key, T, MaxLevel, Multi, Storage>::find_many(ForwardIt first,
+                                                       ForwardIt last,
+                                                       OutputIt out)
+{
+    find_group(first, last, [&](const Skip_node* node) {
+        *out++ = iterator{const_cast<Skip_node*>(node)};
+    });
+    return out;
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+template <typename ForwardIt, typename Visitor>
+void Skip_list<Key, T, MaxLevel, Multi, Storage>::find_group(
+    ForwardIt first, ForwardIt last, Visitor visitor) const
+// group prefetching: the keys are processed in groups of find_many_group_size.
+// each lookup of a group is a small state machine running the same descent as
+// find. one step does one comparison and prefetches the node the following
+// step will read, then the next lookup of the group gets its turn. by the
+// time a lookup is resumed its node is hopefully in the cache already.
+// the visitor gets the found node or nullptr for each key in input order.
+// with Multi equal keys go down as well so the first of them is found
+{
+    struct Lookup {
+        ForwardIt key;
+        Skip_node* const* next;
+        size_type level;
+        const Skip_node* result;
+    };
+
+    Lookup lookups[find_many_group_size];
+
+    while (first != last) {
+        auto group_size = size_type{};
+        for (; first != last && group_size < find_many_group_size;
+             ++first, ++group_size) {
+            auto& lookup = lookups[group_size];
+            lookup = Lookup{first, head.data(), head.size(), nullptr};
+            prefetch(lookup.next[lookup.level - 1]);
+        }
+
+        auto active = group_size;
+        while (active > 0) {
+            for (auto i = size_type{}; i < group_size; ++i) {
+                auto& lookup = lookups[i];
+
+                if (lookup.level == 0) { // already finished
+                    continue;
+                }
+
+                const auto index = lookup.level - 1;
+                const auto node = lookup.next[index];
+
+                const auto go_down = !node || node->key() > *lookup.key ||
+                                     (Multi && node->key() == *lookup.key);
+
+                if (go_down) {
+                    if (--lookup.level == 0) {
+                        if (Multi && node && node->key() == *lookup.key) {
+                            lookup.result = node;
+                        }
+                        --active;
+                    }
+                    else {
+                        prefetch(lookup.next[index - 1]);
+                    }
+                }
+                else if (node->key() == *lookup.key) {
+                    lookup.result = node;
+                    lookup.level = 0;
+                    --active;
+                }
+                else {
+                    lookup.next = node->next;
+                    prefetch(lookup.next[index]);
+                }
+            }
+        }
+
+        for (auto i = size_type{}; i < group_size; ++i) {
+            visitor(lookups[i].result);
+        }
+    }
+}
+
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+void Skip_list<Key, T, MaxLevel, Multi, Storage>::debug_print(
+    std::ostream& os) const
 // debug routine to print with all available layers
 {
     if (head[0] == nullptr) {
@@ -479,66 +1386,65 @@ void Skip_list<Key, T>::debug_print(std::ostream& os) const
             }
         }
         else {
-            os << next[index]->value.first << '/' << next[index]->value.second
-               << ' ';
+            os << next[index]->key();
+            if constexpr (!std::is_void_v<mapped_type>) {
+                os << '/' << next[index]->value.second;
+            }
+            os << ' ';
             next = next[index]->next;
         }
     }
 }
 
-template <typename Key, typename T>
-typename Skip_list<Key, T>::size_type Skip_list<Key, T>::generate_level() const
-// generate height of new node
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::Skip_node*
+Skip_list<Key, T, MaxLevel, Multi, Storage>::allocate_node(value_type value,
+                                                           size_type levels)
 {
-    size_type new_node_level = size_type{};
-
-    do {
-        ++new_node_level;
-    } while (new_node_level <= head.size() && next_level());
+    const auto node = Storage::allocate(node_size(levels), alignof(Skip_node));
+    new (node) Skip_node{std::move(value), levels, nullptr};
 
-    return new_node_level;
+    return reinterpret_cast<Skip_node*>(node);
 }
 
-template <typename Key, typename T>
-bool Skip_list<Key, T>::next_level() noexcept
-// arround 50% chance that next level is reached
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+void Skip_list<Key, T, MaxLevel, Multi, Storage>::free_node(Skip_node* node)
 {
-    static auto engine = std::mt19937{std::random_device{}()};
-    static auto value = std::mt19937::result_type{0};
-    static auto bit = std::mt19937::word_size;
-
-    if (bit >= std::mt19937::word_size) {
-        value = engine();
-        bit = 0;
-    }
-
-    const auto mask = std::mt19937::result_type{1} << (bit++);
-    return value & mask;
+    const auto size = node_size(node->levels);
+    node->~Skip_node();
+    Storage::deallocate(node, size, alignof(Skip_node));
 }
 
-template <typename Key, typename T>
-typename Skip_list<Key, T>::Skip_node*
-Skip_list<Key, T>::allocate_node(value_type value, size_type levels)
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+typename Skip_list<Key, T, MaxLevel, Multi, Storage>::Skip_node*
+Skip_list<Key, T, MaxLevel, Multi, Storage>::copy_node_to(void* memory,
+                                                          const Skip_node* node)
+// the links are set by the caller, next[0] is cleared so the copy always
+// ends the chain free_all_nodes walks
 {
-    const auto node_size =
-        sizeof(Skip_node) + (levels - 1) * sizeof(Skip_node*);
+    if constexpr (std::is_trivially_copyable_v<Skip_node>) {
+        std::memcpy(memory, node, node_size(node->levels));
 
-    const auto node = std::aligned_alloc(alignof(Skip_node), node_size);
-    new (node) Skip_node{std::move(value), levels, nullptr};
-
-    return reinterpret_cast<Skip_node*>(node);
-}
-
-template <typename Key, typename T>
-void Skip_list<Key, T>::free_node(Skip_node* node)
-{
-    node->~Skip_node();
-    std::free(node);
+        const auto copy = static_cast<Skip_node*>(memory);
+        copy->next[0] = nullptr;
+        return copy;
+    }
+    else {
+        return new (memory) Skip_node{node->value, node->levels, nullptr};
+    }
 }
 
-template <typename Key, typename T>
-void Skip_list<Key, T>::copy_nodes(const Skip_list& other)
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+void Skip_list<Key, T, MaxLevel, Multi, Storage>::copy_nodes(
+    const Skip_list& other)
 // precondition: head isn't owner of any nodes
+//
+// the towers are sized and allocated Storage::sequence_length at a time, so
+// the storage can hand out their memory in one go
 {
     head.assign(other.head.size(), nullptr);
 
@@ -548,12 +1454,40 @@ void Skip_list<Key, T>::copy_nodes(const Skip_list& other)
     std::for_each(std::begin(head), std::end(head),
                   [&](auto&& link) { tail.push_back(&link); });
 
-    for (auto node = other.head[0]; node != nullptr; node = node->next[0]) {
-        const auto copy_node = allocate_node(node->value, node->levels);
+    auto sizes = std::vector<std::size_t>{};
+    auto memory = std::vector<void*>{};
+
+    for (auto node = other.head[0]; node != nullptr;) {
+        const auto first = node;
 
-        for (auto i = 0u; i < copy_node->levels; ++i) {
-            *tail[i] = copy_node;
-            tail[i] = &copy_node->next[i];
+        sizes.clear();
+        for (; node != nullptr && sizes.size() < Storage::sequence_length;
+             node = node->next[0]) {
+            sizes.push_back(node_size(node->levels));
+        }
+
+        memory.resize(sizes.size());
+        Storage::allocate_sequence(sizes.size(), sizes.data(),
+                                   alignof(Skip_node), memory.data());
+
+        auto index = size_type{};
+        try {
+            for (auto source = first; source != node;
+                 source = source->next[0], ++index) {
+                const auto copy_node = copy_node_to(memory[index], source);
+
+                for (auto i = 0u; i < copy_node->levels; ++i) {
+                    *tail[i] = copy_node;
+                    tail[i] = &copy_node->next[i];
+                }
+            }
+        }
+        catch (...) { // the linked nodes are freed by the caller
+            for (; index < sizes.size(); ++index) {
+                Storage::deallocate(memory[index], sizes[index],
+                                    alignof(Skip_node));
+            }
+            throw;
         }
     }
 
@@ -561,8 +1495,10 @@ void Skip_list<Key, T>::copy_nodes(const Skip_list& other)
                   [](auto link) { *link = nullptr; });
 }
 
-template <typename Key, typename T>
-void Skip_list<Key, T>::free_all_nodes(Skip_node* head) noexcept
+template <typename Key, typename T, std::size_t MaxLevel, bool Multi,
+          typename Storage>
+void Skip_list<Key, T, MaxLevel, Multi, Storage>::free_all_nodes(
+    Skip_node* head) noexcept
 {
     for (auto index = head; index != nullptr;) {
         const auto temp = index;
@@ -570,5 +1506,10 @@ void Skip_list<Key, T>::free_all_nodes(Skip_node* head) noexcept
         free_node(temp);
     }
 }
+template <typename Key, typename T>
+using Skip_multimap = Skip_list<Key, T, 0, true>;
+
+template <typename Key> using Skip_set = Skip_list<Key, void>;
+
 } // namespace skip_list
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,139 @@
+#ifndef SKIP_LIST_DETAIL_H
+#define SKIP_LIST_DETAIL_H
+
+#include <cassert>
+#include <cstddef>     // std::size_t, std::ptrdiff_t
+#include <iterator>    // std::forward_iterator_tag
+#include <random>      // generation of the levels
+#include <type_traits> // std::conditional_t
+
+// parts shared by the skip list classes, not meant to be used directly
+namespace skip_list {
+namespace detail {
+
+// cap of the lists which record their search path in a fixed array
+inline constexpr std::size_t fixed_path_levels = 32;
+
+// around 50% chance that the next level is reached. thread_local so lists
+// used from different threads don't share the engine
+inline bool next_level() noexcept
+{
+    thread_local auto engine = std::mt19937{std::random_device{}()};
+    thread_local auto value = std::mt19937::result_type{0};
+    thread_local auto bit = std::mt19937::word_size;
+
+    if (bit >= std::mt19937::word_size) {
+        value = engine();
+        bit = 0;
+    }
+
+    const auto mask = std::mt19937::result_type{1} << (bit++);
+    return value & mask;
+}
+
+// height of a new node in a list of the given height: at most one level
+// above it and at most max_level, 0 for no limit
+inline std::size_t generate_level(std::size_t height,
+                                  std::size_t max_level) noexcept
+{
+    auto new_node_level = std::size_t{};
+
+    do {
+        ++new_node_level;
+    } while (new_node_level <= height &&
+             (max_level == 0 || new_node_level < max_level) && next_level());
+
+    return new_node_level;
+}
+
+// forward iterator along level 0 of nodes which hold a value and a next
+// array. only Owner can create one from a node and read the node back
+template <typename Owner, typename Node, typename it_value_type>
+class Node_iterator {
+public:
+    using value_type = it_value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = value_type*;
+    using reference = value_type&;
+    using iterator_category = std::forward_iterator_tag;
+    using node_type =
+        std::conditional_t<std::is_const_v<value_type>, const Node, Node>;
+
+    Node_iterator() = default;
+
+    // iterator converts to const_iterator
+    template <typename other_value_type,
+              typename = std::enable_if_t<
+                  !std::is_const_v<other_value_type> &&
+                  std::is_same_v<const other_value_type, value_type>>>
+    constexpr Node_iterator(
+        const Node_iterator<Owner, Node, other_value_type>& other) noexcept
+        : curr{other.curr}
+    {
+    }
+
+    constexpr bool operator==(const Node_iterator& b) const noexcept
+    {
+        return curr == b.curr;
+    }
+    constexpr bool operator!=(const Node_iterator& b) const noexcept
+    {
+        return curr != b.curr;
+    }
+
+    Node_iterator& operator++() noexcept
+    {
+        assert(curr != nullptr);
+
+        curr = curr->next[0];
+        return *this;
+    }
+
+    Node_iterator operator++(int) noexcept
+    {
+        assert(curr != nullptr);
+
+        auto temp = *this;
+        operator++();
+        return temp;
+    }
+
+    constexpr Node_iterator& operator+=(const int offset) noexcept
+    {
+        for (int i = 0; i < offset; ++i) {
+            ++(*this);
+        }
+        return *this;
+    }
+
+    constexpr Node_iterator operator+(const int offset) const noexcept
+    {
+        auto it = *this;
+        it += offset;
+        return it;
+    }
+
+    constexpr value_type& operator*() const noexcept
+    {
+        return curr->value;
+    }
+
+    constexpr value_type* operator->() const noexcept
+    {
+        return &curr->value;
+    }
+
+private:
+    explicit constexpr Node_iterator(node_type* pos) noexcept : curr{pos}
+    {
+    }
+
+    node_type* curr = nullptr;
+
+    friend Owner;
+    template <typename, typename, typename> friend class Node_iterator;
+};
+
+} // namespace detail
+} // namespace skip_list
+#endif
@@ -0,0 +1,490 @@
+#ifndef SMALL_SKIP_LIST_H
+#define SMALL_SKIP_LIST_H
+
+#include "skip_list.h"
+
+#include <cassert>
+#include <iterator>    // std::forward_iterator_tag
+#include <new>         // placement new
+#include <optional>    // the list exists only after promotion
+#include <type_traits> // std::conditional_t
+#include <utility>     // std::pair
+
+namespace skip_list {
+
+// Skip list which keeps up to N elements in an inline sorted array and
+// searches them with a branch free binary search. inserting element N + 1
+// moves everything into a Skip_list. once erase shrinks it to N / 2 elements
+// it moves back into the array. the gap between both points keeps a list
+// which grows and shrinks around N from switching on every operation.
+//
+// the iterators work in both representations, but they are not stable
+// across changes: like std::vector, insert and erase invalidate iterators
+// while the elements are inline, and a switch of the representation
+// invalidates all of them. the iterator insert returns is always valid, after
+// an erase find() or lower_bound() give a new one. iterators which survive a
+// switch would have to hold a copy of their key and search again on every
+// use, which costs the small case more than it saves.
+//
+// only values which move without throwing are kept inline, the shifts of an
+// insert or erase move them. with a key whose copy can throw, e.g.
+// std::string, the pair's move copies the key and a throw half way through a
+// shift would leave a hole in the array, so those lists always use the
+// Skip_list.
+template <typename Key, typename T, std::size_t N = 16> class Small_skip_list {
+public:
+    using list_type = Skip_list<Key, T>;
+    using key_type = typename list_type::key_type;
+    using mapped_type = typename list_type::mapped_type;
+    using value_type = typename list_type::value_type;
+    using size_type = typename list_type::size_type;
+
+    static_assert(N > 0, "inline capacity must not be 0");
+
+    static constexpr bool inline_values =
+        std::is_nothrow_move_constructible_v<value_type>;
+
+    template <typename it_value_type, typename list_iterator>
+    class iterator_base {
+    public:
+        using value_type = it_value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = value_type*;
+        using reference = value_type&;
+        using iterator_category = std::forward_iterator_tag;
+
+        iterator_base() = default;
+
+        constexpr bool operator==(const iterator_base& b) const noexcept
+        {
+            return slot == b.slot && node == b.node;
+        }
+        constexpr bool operator!=(const iterator_base& b) const noexcept
+        {
+            return !(*this == b);
+        }
+
+        iterator_base& operator++() noexcept
+        {
+            if (slot) {
+                ++slot;
+            }
+            else {
+                ++node;
+            }
+            return *this;
+        }
+
+        iterator_base operator++(int) noexcept
+        {
+            auto temp = *this;
+            operator++();
+            return temp;
+        }
+
+        constexpr value_type& operator*() const noexcept
+        {
+            if (slot) {
+                return *slot;
+            }
+            auto pos = node; // the const overload of node hands out const
+            return *pos;
+        }
+
+        constexpr value_type* operator->() const noexcept
+        {
+            return &**this;
+        }
+
+    private:
+        explicit constexpr iterator_base(value_type* pos) noexcept : slot{pos}
+        {
+        }
+
+        explicit constexpr iterator_base(list_iterator pos) noexcept
+            : node{pos}
+        {
+        }
+
+        value_type* slot = nullptr; // set while the elements are inline
+        list_iterator node;
+
+        friend class Small_skip_list;
+    };
+
+    using iterator =
+        iterator_base<value_type, typename list_type::iterator>;
+    using const_iterator =
+        iterator_base<const value_type, typename list_type::const_iterator>;
+
+    Small_skip_list() = default;
+
+    ~Small_skip_list()
+    {
+        if (!list) {
+            destroy_slots();
+        }
+    }
+
+    Small_skip_list(const Small_skip_list& other)
+    {
+        try {
+            copy_from(other);
+        }
+        catch (...) { // the destructor does not run
+            destroy_slots();
+            throw;
+        }
+    }
+
+    Small_skip_list& operator=(const Small_skip_list& other)
+    {
+        if (this != &other) {
+            clear();
+            copy_from(other);
+        }
+        return *this;
+    }
+
+    // noexcept because only inline_values are moved one by one, the list
+    // moves as a whole
+    Small_skip_list(Small_skip_list&& other) noexcept
+    {
+        move_from(other);
+    }
+
+    Small_skip_list& operator=(Small_skip_list&& other) noexcept
+    {
+        if (this != &other) {
+            clear();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    iterator begin() noexcept
+    {
+        return list ? iterator{list->begin()} : iterator{slots()};
+    }
+
+    iterator end() noexcept
+    {
+        return list ? iterator{list->end()} : iterator{slots() + elements};
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return list ? const_iterator{std::as_const(*list).begin()}
+                    : const_iterator{slots()};
+    }
+
+    const_iterator end() const noexcept
+    {
+        return list ? const_iterator{std::as_const(*list).end()}
+                    : const_iterator{slots() + elements};
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    bool empty() const noexcept
+    {
+        return elements == 0;
+    }
+
+    size_type size() const noexcept
+    {
+        return elements;
+    }
+
+    // true while the elements are stored inline
+    bool is_small() const noexcept
+    {
+        return !list;
+    }
+
+    mapped_type& operator[](const key_type& key)
+    {
+        return find(key)->second;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value);
+
+    size_type erase(const key_type& key);
+
+    void clear() noexcept;
+
+    iterator find(const key_type& key);
+    const_iterator find(const key_type& key) const;
+
+    iterator lower_bound(const key_type& key);
+    const_iterator lower_bound(const key_type& key) const;
+
+    size_type count(const key_type& key) const
+    {
+        return find(key) != end() ? 1 : 0;
+    }
+
+private:
+    value_type* slots() noexcept
+    {
+        return reinterpret_cast<value_type*>(storage);
+    }
+    const value_type* slots() const noexcept
+    {
+        return reinterpret_cast<const value_type*>(storage);
+    }
+
+    size_type lower_index(const key_type& key) const noexcept;
+
+    void promote();
+    void demote();
+
+    void destroy_slots() noexcept
+    {
+        for (auto i = size_type{}; i < elements; ++i) {
+            slots()[i].~value_type();
+        }
+    }
+
+    void copy_from(const Small_skip_list& other);
+    void move_from(Small_skip_list& other) noexcept;
+
+    alignas(value_type) unsigned char storage[N * sizeof(value_type)];
+    size_type elements = 0;
+    std::optional<list_type> list;
+};
+
+template <typename Key, typename T, std::size_t N>
+std::pair<typename Small_skip_list<Key, T, N>::iterator, bool>
+Small_skip_list<Key, T, N>::insert(const value_type& value)
+// same semantics as Skip_list::insert, a present key gets its value replaced
+{
+    if (!list) {
+        if constexpr (inline_values) {
+            const auto index = lower_index(value.first);
+            const auto slot = slots() + index;
+
+            if (index < elements && slot->first == value.first) {
+                slot->second = value.second;
+                return std::make_pair(iterator{slot}, true);
+            }
+
+            if (elements < N) {
+                // copied before the shift, which can't throw, so a throwing
+                // copy leaves the array untouched
+                auto inserted = value_type{value};
+
+                // the key is const so the tail is moved by reconstructing
+                for (auto i = elements; i > index; --i) {
+                    new (slots() + i) value_type{std::move(slots()[i - 1])};
+                    slots()[i - 1].~value_type();
+                }
+                new (slot) value_type{std::move(inserted)};
+                ++elements;
+                return std::make_pair(iterator{slot}, true);
+            }
+        }
+
+        promote();
+    }
+
+    // looked up first because the size of the list is not known in O(1)
+    if (auto it = list->find(value.first); it != list->end()) {
+        it->second = value.second;
+        return std::make_pair(iterator{it}, true);
+    }
+
+    const auto position = list->insert(value).first;
+    ++elements;
+    return std::make_pair(iterator{position}, true);
+}
+
+template <typename Key, typename T, std::size_t N>
+typename Small_skip_list<Key, T, N>::size_type
+Small_skip_list<Key, T, N>::erase(const key_type& key)
+{
+    if (!list) {
+        const auto index = lower_index(key);
+
+        if (index == elements || !(slots()[index].first == key)) {
+            return 0;
+        }
+
+        slots()[index].~value_type();
+        for (auto i = index + 1; i < elements; ++i) {
+            new (slots() + i - 1) value_type{std::move(slots()[i])};
+            slots()[i].~value_type();
+        }
+        --elements;
+        return 1;
+    }
+
+    const auto erased = list->erase(key);
+    elements -= erased;
+
+    if constexpr (inline_values) {
+        if (elements <= N / 2) {
+            demote();
+        }
+    }
+    return erased;
+}
+
+template <typename Key, typename T, std::size_t N>
+void Small_skip_list<Key, T, N>::clear() noexcept
+{
+    if (list) {
+        list.reset();
+    }
+    else {
+        destroy_slots();
+    }
+    elements = 0;
+}
+
+template <typename Key, typename T, std::size_t N>
+typename Small_skip_list<Key, T, N>::const_iterator
+Small_skip_list<Key, T, N>::find(const key_type& key) const
+{
+    if (list) {
+        return const_iterator{std::as_const(*list).find(key)};
+    }
+
+    const auto index = lower_index(key);
+    if (index < elements && slots()[index].first == key) {
+        return const_iterator{slots() + index};
+    }
+    return end();
+}
+
+template <typename Key, typename T, std::size_t N>
+typename Small_skip_list<Key, T, N>::iterator
+Small_skip_list<Key, T, N>::find(const key_type& key)
+{
+    if (list) {
+        return iterator{list->find(key)};
+    }
+
+    const auto index = lower_index(key);
+    if (index < elements && slots()[index].first == key) {
+        return iterator{slots() + index};
+    }
+    return end();
+}
+
+template <typename Key, typename T, std::size_t N>
+typename Small_skip_list<Key, T, N>::const_iterator
+Small_skip_list<Key, T, N>::lower_bound(const key_type& key) const
+{
+    if (list) {
+        return const_iterator{std::as_const(*list).lower_bound(key)};
+    }
+    return const_iterator{slots() + lower_index(key)};
+}
+
+template <typename Key, typename T, std::size_t N>
+typename Small_skip_list<Key, T, N>::iterator
+Small_skip_list<Key, T, N>::lower_bound(const key_type& key)
+{
+    if (list) {
+        return iterator{list->lower_bound(key)};
+    }
+    return iterator{slots() + lower_index(key)};
+}
+
+template <typename Key, typename T, std::size_t N>
+typename Small_skip_list<Key, T, N>::size_type
+Small_skip_list<Key, T, N>::lower_index(const key_type& key) const noexcept
+// branch free binary search: the range is halved every round and only the
+// start moves, chosen by a conditional move instead of a jump. the count of
+// rounds depends only on the size, never on the keys
+{
+    if (elements == 0) {
+        return 0;
+    }
+
+    auto base = slots();
+    auto length = elements;
+
+    while (length > 1) {
+        const auto half = length / 2;
+        base = key > base[half].first ? base + half : base;
+        length -= half;
+    }
+
+    return static_cast<size_type>(base - slots()) + (key > base->first);
+}
+
+template <typename Key, typename T, std::size_t N>
+void Small_skip_list<Key, T, N>::promote()
+// precondition: elements are inline
+{
+    auto promoted = list_type{};
+    for (auto i = size_type{}; i < elements; ++i) {
+        promoted.insert(slots()[i]);
+    }
+
+    destroy_slots();
+    list.emplace(std::move(promoted));
+}
+
+template <typename Key, typename T, std::size_t N>
+void Small_skip_list<Key, T, N>::demote()
+// precondition: elements are in the list and elements <= N
+{
+    auto index = size_type{};
+    while (!list->empty()) {
+        new (slots() + index++) value_type{list->extract_min()};
+    }
+    list.reset();
+}
+
+template <typename Key, typename T, std::size_t N>
+void Small_skip_list<Key, T, N>::copy_from(const Small_skip_list& other)
+// precondition: this is empty and inline
+//
+// elements counts the copied slots, so after a throw it covers exactly the
+// constructed ones
+{
+    if (other.list) {
+        list.emplace(*other.list);
+    }
+    else {
+        for (; elements < other.elements; ++elements) {
+            new (slots() + elements) value_type{other.slots()[elements]};
+        }
+    }
+    elements = other.elements;
+}
+
+template <typename Key, typename T, std::size_t N>
+void Small_skip_list<Key, T, N>::move_from(Small_skip_list& other) noexcept
+// precondition: this is empty and inline
+{
+    if (other.list) {
+        list.emplace(std::move(*other.list));
+        elements = other.elements;
+        other.list.reset();
+        other.elements = 0;
+        return;
+    }
+
+    if constexpr (inline_values) {
+        for (; elements < other.elements; ++elements) {
+            new (slots() + elements)
+                value_type{std::move(other.slots()[elements])};
+        }
+        other.clear();
+    }
+}
+
+} // namespace skip_list
+#endif
@@ -0,0 +1,491 @@
+#ifndef STRING_SKIP_LIST_H
+#define STRING_SKIP_LIST_H
+
+#include "skip_list_detail.h"
+
+#include <algorithm>   // std::min
+#include <cassert>
+#include <cstdlib>     // aligned_alloc() and free()
+#include <cstring>     // std::memcpy
+#include <memory>      // std::unique_ptr
+#include <new>         // placement new
+#include <string_view> // keys
+#include <utility>     // std::pair, std::exchange
+#include <vector>      // for head implementation and arena blocks
+
+namespace skip_list {
+
+// copies keys into large blocks, so a key costs its characters and no
+// allocation of its own. the bytes of erased keys are not reused, the owner
+// moves the live keys into a fresh arena instead, see String_skip_list::shrink
+class Key_arena {
+public:
+    using size_type = std::size_t;
+
+    Key_arena() = default;
+
+    Key_arena(const Key_arena&) = delete;
+    Key_arena& operator=(const Key_arena&) = delete;
+
+    // the moved from arena is empty and starts a new block on the next key
+    Key_arena(Key_arena&& other) noexcept
+        : blocks{std::move(other.blocks)}, large{std::move(other.large)},
+          used{std::exchange(other.used, block_size)},
+          allocated{std::exchange(other.allocated, 0)},
+          interned{std::exchange(other.interned, 0)}
+    {
+        other.blocks.clear();
+        other.large.clear();
+    }
+
+    Key_arena& operator=(Key_arena&& other) noexcept
+    {
+        auto temp = std::move(other);
+        swap(*this, temp);
+        return *this;
+    }
+
+    friend void swap(Key_arena& a, Key_arena& b) noexcept
+    {
+        using std::swap;
+        swap(a.blocks, b.blocks);
+        swap(a.large, b.large);
+        swap(a.used, b.used);
+        swap(a.allocated, b.allocated);
+        swap(a.interned, b.interned);
+    }
+
+    // true if intern(key) has to allocate a block
+    bool grows(std::string_view key) const noexcept
+    {
+        return !key.empty() &&
+               (key.size() > block_size / 4 || block_size - used < key.size());
+    }
+
+    std::string_view intern(std::string_view key)
+    {
+        if (key.empty()) {
+            return std::string_view{};
+        }
+
+        if (key.size() > block_size / 4) { // own block, keep the current one
+            large.push_back(std::make_unique<char[]>(key.size()));
+            allocated += key.size();
+            interned += key.size();
+            return copy(large.back().get(), key);
+        }
+
+        if (block_size - used < key.size()) {
+            blocks.push_back(std::make_unique<char[]>(block_size));
+            allocated += block_size;
+            used = 0;
+        }
+
+        const auto result = copy(blocks.back().get() + used, key);
+        used += key.size();
+        interned += key.size();
+        return result;
+    }
+
+    size_type bytes() const noexcept // memory held by the blocks
+    {
+        return allocated;
+    }
+
+    size_type interned_bytes() const noexcept // characters handed out
+    {
+        return interned;
+    }
+
+private:
+    static std::string_view copy(char* destination, std::string_view key)
+    {
+        std::memcpy(destination, key.data(), key.size());
+        return std::string_view{destination, key.size()};
+    }
+
+    static constexpr size_type block_size = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::vector<std::unique_ptr<char[]>> large;
+    size_type used = block_size; // of the last block
+    size_type allocated = 0;
+    size_type interned = 0;
+};
+
+// Skip list for string keys. the characters of all keys live in a Key_arena
+// and the nodes only hold a std::string_view into it, so long keys don't cost
+// an extra allocation per node.
+//
+// the search skips the prefix every key in the search window is known to
+// share with the searched key: all nodes between the last node smaller than
+// the key and the last node not smaller than it have at least the shorter of
+// both common prefixes with the key. comparing starts behind it. for keys
+// like paths which share long prefixes most characters are never looked at
+// again after the upper levels. a node already known to be not smaller is
+// not compared again either.
+//
+// erased keys leave dead bytes in the arena. an insert which needs a new
+// arena block while the dead bytes outnumber the live ones calls shrink()
+// first, so the arena stays within about twice the live keys. that moves
+// every node: like with std::vector, such an insert invalidates all
+// iterators.
+//
+// the keys are stored whole, not front coded against their predecessor: the
+// nodes hand out contiguous views, and decoding a front coded key would walk
+// the level 0 chain back to a full key on every read. the memory saved is
+// the allocation and the std::string per key, the shared prefixes are still
+// stored once per key.
+template <typename T> class String_skip_list {
+private:
+    struct Skip_node;
+
+    std::vector<Skip_node*> head = std::vector<Skip_node*>(1, nullptr);
+
+public:
+    using key_type = std::string_view;
+    using mapped_type = T;
+
+    using value_type = std::pair<const key_type, mapped_type>;
+    using size_type = std::size_t;
+
+    template <typename it_value_type>
+    using iterator_base =
+        detail::Node_iterator<String_skip_list, Skip_node, it_value_type>;
+
+    using iterator = iterator_base<value_type>;
+    using const_iterator = iterator_base<const value_type>;
+
+    String_skip_list() = default;
+
+    ~String_skip_list()
+    {
+        free_all_nodes(head[0]);
+    }
+
+    String_skip_list(const String_skip_list& other)
+    // the keys are interned into the arena of the copy, already in order
+    {
+        for (const auto& value : other) {
+            insert(value);
+        }
+    }
+
+    String_skip_list& operator=(const String_skip_list& other)
+    {
+        auto temp = other;
+        swap(temp, *this);
+        return *this;
+    }
+
+    friend void swap(String_skip_list& a, String_skip_list& b) noexcept
+    {
+        using std::swap;
+        swap(a.head, b.head);
+        swap(a.arena, b.arena);
+        swap(a.node_count, b.node_count);
+        swap(a.key_bytes, b.key_bytes);
+    }
+
+    String_skip_list(String_skip_list&& other) noexcept : String_skip_list{}
+    {
+        swap(*this, other);
+    }
+
+    String_skip_list& operator=(String_skip_list&& other) noexcept
+    {
+        swap(*this, other);
+        return *this;
+    }
+
+    iterator begin() noexcept
+    {
+        return iterator{head[0]};
+    }
+
+    iterator end() noexcept
+    {
+        return iterator{nullptr};
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return const_iterator{head[0]};
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator{nullptr};
+    }
+
+    bool empty() const noexcept
+    {
+        return head[0] == nullptr;
+    }
+
+    size_type size() const noexcept
+    {
+        return node_count;
+    }
+
+    mapped_type& operator[](key_type key)
+    {
+        return find(key)->second;
+    }
+
+    // the key is copied into the arena, the caller's string is not kept.
+    // if the key is present its value is replaced
+    std::pair<iterator, bool> insert(const value_type& value);
+
+    size_type erase(key_type key);
+
+    void clear() noexcept
+    {
+        free_all_nodes(head[0]);
+        head.assign(1, nullptr);
+        arena = Key_arena{};
+        node_count = 0;
+        key_bytes = 0;
+    }
+
+    iterator find(key_type key);
+    const_iterator find(key_type key) const;
+
+    iterator lower_bound(key_type key);
+    const_iterator lower_bound(key_type key) const;
+
+    size_type count(key_type key) const
+    {
+        return find(key) != end() ? 1 : 0;
+    }
+
+    // moves the keys into a fresh arena without gaps, the bytes of erased
+    // keys are given back. copies all elements, O(n log n). the list is
+    // unchanged if it throws
+    void shrink()
+    {
+        auto packed = *this;
+        swap(*this, packed);
+    }
+
+    // bytes the arena holds and how many of the interned ones belong to
+    // erased keys. copying the list packs the keys of the copy without gaps
+    size_type arena_bytes() const noexcept
+    {
+        return arena.bytes();
+    }
+
+    size_type dead_bytes() const noexcept
+    {
+        return arena.interned_bytes() - key_bytes;
+    }
+
+private:
+    static constexpr size_type max_level = detail::fixed_path_levels;
+
+    struct Skip_node {
+        value_type value; // key view into the arena / T
+        size_type levels;
+        Skip_node* next[1];
+    };
+
+    Skip_node* search(key_type key, Skip_node** path[]) const;
+
+    size_type generate_level() const
+    {
+        return detail::generate_level(head.size(), max_level);
+    }
+
+    static Skip_node* allocate_node(value_type value, size_type levels);
+    static void free_node(Skip_node* node);
+    static void free_all_nodes(Skip_node* head) noexcept;
+
+    Key_arena arena;
+    size_type node_count = 0;
+    size_type key_bytes = 0; // characters of the keys still in the list
+};
+
+template <typename T>
+std::pair<typename String_skip_list<T>::iterator, bool>
+String_skip_list<T>::insert(const value_type& value)
+{
+    Skip_node** path[max_level];
+
+    const auto insert_level = generate_level();
+    while (head.size() < insert_level) { // before the path points into head
+        head.push_back(nullptr);
+    }
+
+    const auto node = search(value.first, path);
+
+    if (node && node->value.first == value.first) {
+        node->value.second = value.second;
+
+        while (head.size() > 1 && head.back() == nullptr) {
+            head.pop_back();
+        }
+        return std::make_pair(iterator{node}, true);
+    }
+
+    if (arena.grows(value.first) && dead_bytes() > key_bytes) {
+        shrink();
+        return insert(value); // the path led through the old nodes
+    }
+
+    const auto key = arena.intern(value.first);
+    const auto insert_node =
+        allocate_node(value_type{key, value.second}, insert_level);
+
+    for (auto i = size_type{}; i < insert_level; ++i) {
+        insert_node->next[i] = path[i][i];
+        path[i][i] = insert_node;
+    }
+
+    ++node_count;
+    key_bytes += key.size();
+    return std::make_pair(iterator{insert_node}, true);
+}
+
+template <typename T>
+typename String_skip_list<T>::size_type String_skip_list<T>::erase(key_type key)
+{
+    Skip_node** path[max_level];
+
+    const auto node = search(key, path);
+
+    if (!node || node->value.first != key) {
+        return 0;
+    }
+
+    for (auto i = size_type{}; i < node->levels; ++i) {
+        path[i][i] = node->next[i];
+    }
+
+    while (head.size() > 1 && head.back() == nullptr) {
+        head.pop_back();
+    }
+
+    --node_count;
+    key_bytes -= node->value.first.size();
+    free_node(node);
+    return 1;
+}
+
+template <typename T>
+typename String_skip_list<T>::const_iterator
+String_skip_list<T>::find(key_type key) const
+{
+    const auto node = search(key, nullptr);
+    return node && node->value.first == key ? const_iterator{node} : end();
+}
+
+template <typename T>
+typename String_skip_list<T>::iterator String_skip_list<T>::find(key_type key)
+{
+    const auto node = search(key, nullptr);
+    return node && node->value.first == key ? iterator{node} : end();
+}
+
+template <typename T>
+typename String_skip_list<T>::const_iterator
+String_skip_list<T>::lower_bound(key_type key) const
+{
+    return const_iterator{search(key, nullptr)};
+}
+
+template <typename T>
+typename String_skip_list<T>::iterator
+String_skip_list<T>::lower_bound(key_type key)
+{
+    return iterator{search(key, nullptr)};
+}
+
+template <typename T>
+typename String_skip_list<T>::Skip_node*
+String_skip_list<T>::search(key_type key, Skip_node** path[]) const
+// returns the first node not smaller than key. if path is given it gets for
+// each level the links of the last node smaller than key.
+//
+// lower is the common prefix length of key and the last node smaller than
+// it, upper the one of key and the last node not smaller. every node in
+// between shares the shorter of both with key
+{
+    auto level = head.size();
+    auto next = const_cast<Skip_node**>(head.data());
+
+    auto lower = size_type{};
+    auto upper = size_type{};
+    const Skip_node* bound = nullptr; // last node not smaller than key
+
+    while (level > 0) {
+        const auto index = level - 1;
+        const auto node = next[index];
+
+        if (node == nullptr || node == bound) {
+            if (path) {
+                path[index] = next;
+            }
+            --level;
+            continue;
+        }
+
+        const auto& node_key = node->value.first;
+        const auto length = std::min(key.size(), node_key.size());
+
+        auto common = std::min(lower, upper);
+        while (common < length && key[common] == node_key[common]) {
+            ++common;
+        }
+
+        const auto key_is_bigger =
+            common < length
+                ? static_cast<unsigned char>(key[common]) >
+                      static_cast<unsigned char>(node_key[common])
+                : key.size() > node_key.size();
+
+        if (key_is_bigger) {
+            lower = common;
+            next = node->next;
+        }
+        else {
+            upper = common;
+            bound = node;
+            if (path) {
+                path[index] = next;
+            }
+            --level;
+        }
+    }
+    return next[0];
+}
+
+template <typename T>
+typename String_skip_list<T>::Skip_node*
+String_skip_list<T>::allocate_node(value_type value, size_type levels)
+{
+    const auto node_size =
+        sizeof(Skip_node) + (levels - 1) * sizeof(Skip_node*);
+
+    const auto node = std::aligned_alloc(alignof(Skip_node), node_size);
+    new (node) Skip_node{std::move(value), levels, nullptr};
+
+    return reinterpret_cast<Skip_node*>(node);
+}
+
+template <typename T> void String_skip_list<T>::free_node(Skip_node* node)
+{
+    node->~Skip_node();
+    std::free(node);
+}
+
+template <typename T>
+void String_skip_list<T>::free_all_nodes(Skip_node* head) noexcept
+{
+    for (auto index = head; index != nullptr;) {
+        const auto temp = index;
+        index = index->next[0];
+        free_node(temp);
+    }
+}
+} // namespace skip_list
+#endif
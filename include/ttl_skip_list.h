@@ -0,0 +1,531 @@
+#ifndef TTL_SKIP_LIST_H
+#define TTL_SKIP_LIST_H
+
+#include "skip_list_detail.h"
+
+#include <algorithm>   // std::max
+#include <cassert>
+#include <chrono>      // default deadline type
+#include <cstdlib>     // aligned_alloc() and free()
+#include <new>         // placement new
+#include <optional>    // next_deadline()
+#include <utility>     // std::pair
+#include <vector>      // for head implementation
+
+namespace skip_list {
+
+// Skip list whose elements expire. every node is linked into two skip lists
+// at once: by key, for the usual lookups, and by (deadline, key), so the
+// entries due next are always at the front of the second order.
+// expire_until() takes them from there instead of scanning all elements.
+//
+// a node has one tower for each order, both in the same allocation. the
+// heights are drawn independently. the key tower links backwards as well, so
+// a node leaves the key order without a search. an expired entry is first on
+// all of its time levels, so it leaves the time order without a search too.
+// reaping k entries costs O(k) expected, however many entries are not due
+// yet. the back links cost one pointer per key level.
+template <typename Key, typename T,
+          typename Time = std::chrono::steady_clock::time_point>
+class Ttl_skip_list {
+private:
+    struct Skip_node;
+
+    std::vector<Skip_node*> key_head = std::vector<Skip_node*>(1, nullptr);
+    std::vector<Skip_node*> time_head = std::vector<Skip_node*>(1, nullptr);
+
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using time_type = Time;
+
+    using value_type = std::pair<const key_type, mapped_type>;
+    using size_type = std::size_t;
+
+    template <typename it_value_type>
+    using iterator_base =
+        detail::Node_iterator<Ttl_skip_list, Skip_node, it_value_type>;
+
+    using iterator = iterator_base<value_type>;
+    using const_iterator = iterator_base<const value_type>;
+
+    Ttl_skip_list() = default;
+
+    ~Ttl_skip_list()
+    {
+        free_all_nodes(key_head[0]);
+    }
+
+    Ttl_skip_list(const Ttl_skip_list& other)
+    {
+        try {
+            for (auto node = other.key_head[0]; node; node = node->next[0]) {
+                insert(node->value, node->deadline);
+            }
+        }
+        catch (...) {
+            free_all_nodes(key_head[0]);
+            throw;
+        }
+    }
+
+    Ttl_skip_list& operator=(const Ttl_skip_list& other)
+    {
+        auto temp = other;
+        swap(temp, *this);
+        return *this;
+    }
+
+    friend void swap(Ttl_skip_list& a, Ttl_skip_list& b) noexcept
+    {
+        using std::swap;
+        swap(a.key_head, b.key_head);
+        swap(a.time_head, b.time_head);
+        swap(a.node_count, b.node_count);
+    }
+
+    Ttl_skip_list(Ttl_skip_list&& other) noexcept : Ttl_skip_list{}
+    {
+        swap(*this, other);
+    }
+
+    Ttl_skip_list& operator=(Ttl_skip_list&& other) noexcept
+    {
+        swap(*this, other);
+        return *this;
+    }
+
+    // iteration is in key order
+    iterator begin() noexcept
+    {
+        return iterator{key_head[0]};
+    }
+
+    iterator end() noexcept
+    {
+        return iterator{nullptr};
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return const_iterator{key_head[0]};
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator{nullptr};
+    }
+
+    bool empty() const noexcept
+    {
+        return key_head[0] == nullptr;
+    }
+
+    size_type size() const noexcept
+    {
+        return node_count;
+    }
+
+    // if the key is present its value and deadline are replaced and the
+    // bool is false
+    std::pair<iterator, bool> insert(const value_type& value,
+                                     time_type deadline);
+
+    size_type erase(const key_type& key);
+
+    void clear() noexcept
+    {
+        free_all_nodes(key_head[0]);
+        key_head.assign(1, nullptr);
+        time_head.assign(1, nullptr);
+        node_count = 0;
+    }
+
+    iterator find(const key_type& key);
+    const_iterator find(const key_type& key) const;
+
+    iterator lower_bound(const key_type& key);
+    const_iterator lower_bound(const key_type& key) const;
+
+    size_type count(const key_type& key) const
+    {
+        return find(key) != end() ? 1 : 0;
+    }
+
+    time_type deadline(const_iterator position) const noexcept
+    {
+        return position.curr->deadline;
+    }
+
+    // moves the element to its new place in the time order. returns false
+    // if the key is not present
+    bool set_deadline(const key_type& key, time_type deadline);
+
+    // the earliest deadline, to know when expire_until has work next
+    std::optional<time_type> next_deadline() const
+    {
+        if (time_head[0] == nullptr) {
+            return std::nullopt;
+        }
+        return time_head[0]->deadline;
+    }
+
+    // removes up to budget elements with a deadline <= now, earliest first,
+    // and returns how many. on_expired(value_type&, time_type) gets each
+    // value after its node is gone and may move it out. if it throws, the
+    // elements removed so far stay removed. a bounded budget lets e.g. a
+    // timer reap a little on every tick
+    template <typename Function>
+    size_type expire_until(time_type now, size_type budget,
+                           Function on_expired);
+
+    size_type expire_until(time_type now, size_type budget)
+    {
+        return expire_until(now, budget, [](value_type&, time_type) {});
+    }
+
+private:
+    static constexpr size_type max_level = detail::fixed_path_levels;
+
+    struct Skip_node {
+        value_type value;
+        time_type deadline;
+        size_type key_levels;
+        size_type time_levels;
+        // key_levels links by key, key_levels links back by key, nullptr for
+        // the head, then time_levels links by deadline
+        Skip_node* next[1];
+
+        const key_type& key() const noexcept
+        {
+            return value.first;
+        }
+
+        Skip_node** prev() noexcept
+        {
+            return next + key_levels;
+        }
+
+        Skip_node** time_next() noexcept
+        {
+            return next + 2 * key_levels;
+        }
+    };
+
+    // the last node in front of key on every level, nullptr for the head.
+    // returns the first node not smaller
+    Skip_node* key_path(const key_type& key, Skip_node* before[]) const;
+    // the last node in front of (deadline, key) on every level as its link
+    // array, so path[i][i] is the link
+    Skip_node* time_path(time_type deadline, const key_type& key,
+                         Skip_node** path[]) const;
+
+    void link_key(Skip_node* before[], Skip_node* node) noexcept;
+    void unlink_key(Skip_node* node) noexcept;
+
+    static void link(Skip_node** path[], Skip_node* node, Skip_node** links,
+                     size_type levels) noexcept;
+    static void unlink(Skip_node** path[], Skip_node** links,
+                       size_type levels) noexcept;
+    static void shrink(std::vector<Skip_node*>& head) noexcept;
+
+
+    static Skip_node* allocate_node(value_type value, time_type deadline,
+                                    size_type key_levels,
+                                    size_type time_levels);
+    static void free_node(Skip_node* node);
+    static void free_all_nodes(Skip_node* head) noexcept;
+
+    size_type node_count = 0;
+};
+
+template <typename Key, typename T, typename Time>
+std::pair<typename Ttl_skip_list<Key, T, Time>::iterator, bool>
+Ttl_skip_list<Key, T, Time>::insert(const value_type& value,
+                                    time_type deadline)
+{
+    if (const auto position = find(value.first); position != end()) {
+        position->second = value.second;
+        set_deadline(value.first, deadline);
+        return std::make_pair(position, false);
+    }
+
+    const auto key_levels = detail::generate_level(key_head.size(), max_level);
+    const auto time_levels =
+        detail::generate_level(time_head.size(), max_level);
+
+    // before the paths point into the heads
+    key_head.resize(std::max(key_head.size(), key_levels), nullptr);
+    time_head.resize(std::max(time_head.size(), time_levels), nullptr);
+
+    const auto node = allocate_node(value, deadline, key_levels, time_levels);
+
+    Skip_node* before[max_level];
+    key_path(value.first, before);
+    link_key(before, node);
+
+    Skip_node** path[max_level];
+    time_path(deadline, value.first, path);
+    link(path, node, node->time_next(), time_levels);
+
+    ++node_count;
+    return std::make_pair(iterator{node}, true);
+}
+
+template <typename Key, typename T, typename Time>
+typename Ttl_skip_list<Key, T, Time>::size_type
+Ttl_skip_list<Key, T, Time>::erase(const key_type& key)
+{
+    const auto node = key_path(key, nullptr);
+    if (!node || !(node->key() == key)) {
+        return 0;
+    }
+    unlink_key(node);
+
+    Skip_node** path[max_level];
+    time_path(node->deadline, key, path);
+    unlink(path, node->time_next(), node->time_levels);
+
+    shrink(key_head);
+    shrink(time_head);
+
+    --node_count;
+    free_node(node);
+    return 1;
+}
+
+template <typename Key, typename T, typename Time>
+bool Ttl_skip_list<Key, T, Time>::set_deadline(const key_type& key,
+                                               time_type deadline)
+{
+    const auto position = find(key);
+    if (position == end()) {
+        return false;
+    }
+
+    const auto node = position.curr;
+    Skip_node** path[max_level];
+
+    time_path(node->deadline, key, path);
+    unlink(path, node->time_next(), node->time_levels);
+
+    node->deadline = deadline;
+    time_path(deadline, key, path);
+    link(path, node, node->time_next(), node->time_levels);
+    return true;
+}
+
+template <typename Key, typename T, typename Time>
+template <typename Function>
+typename Ttl_skip_list<Key, T, Time>::size_type
+Ttl_skip_list<Key, T, Time>::expire_until(time_type now, size_type budget,
+                                          Function on_expired)
+// the node with the earliest deadline is first on all of its time levels,
+// so it leaves the time order without a search. the list is consistent
+// before on_expired runs, whatever it does
+{
+    auto expired = size_type{};
+
+    while (expired < budget && time_head[0] != nullptr &&
+           !(now < time_head[0]->deadline)) {
+        const auto node = time_head[0];
+
+        auto value = std::move(node->value);
+        const auto deadline = node->deadline;
+
+        for (auto i = size_type{}; i < node->time_levels; ++i) {
+            time_head[i] = node->time_next()[i];
+        }
+        unlink_key(node);
+        free_node(node);
+
+        shrink(key_head);
+        shrink(time_head);
+        --node_count;
+        ++expired;
+
+        on_expired(value, deadline);
+    }
+    return expired;
+}
+
+template <typename Key, typename T, typename Time>
+typename Ttl_skip_list<Key, T, Time>::const_iterator
+Ttl_skip_list<Key, T, Time>::find(const key_type& key) const
+{
+    const auto node = key_path(key, nullptr);
+    return node && node->key() == key ? const_iterator{node} : end();
+}
+
+template <typename Key, typename T, typename Time>
+typename Ttl_skip_list<Key, T, Time>::iterator
+Ttl_skip_list<Key, T, Time>::find(const key_type& key)
+{
+    const auto node = key_path(key, nullptr);
+    return node && node->key() == key ? iterator{node} : end();
+}
+
+template <typename Key, typename T, typename Time>
+typename Ttl_skip_list<Key, T, Time>::const_iterator
+Ttl_skip_list<Key, T, Time>::lower_bound(const key_type& key) const
+{
+    return const_iterator{key_path(key, nullptr)};
+}
+
+template <typename Key, typename T, typename Time>
+typename Ttl_skip_list<Key, T, Time>::iterator
+Ttl_skip_list<Key, T, Time>::lower_bound(const key_type& key)
+{
+    return iterator{key_path(key, nullptr)};
+}
+
+template <typename Key, typename T, typename Time>
+typename Ttl_skip_list<Key, T, Time>::Skip_node*
+Ttl_skip_list<Key, T, Time>::key_path(const key_type& key,
+                                      Skip_node* before[]) const
+{
+    auto level = key_head.size();
+    auto next = const_cast<Skip_node**>(key_head.data());
+    auto node = static_cast<Skip_node*>(nullptr);
+
+    while (level > 0) {
+        const auto index = level - 1;
+
+        if (next[index] && key > next[index]->key()) {
+            node = next[index];
+            next = node->next;
+        }
+        else {
+            if (before) {
+                before[index] = node;
+            }
+            --level;
+        }
+    }
+    return next[0];
+}
+
+template <typename Key, typename T, typename Time>
+typename Ttl_skip_list<Key, T, Time>::Skip_node*
+Ttl_skip_list<Key, T, Time>::time_path(time_type deadline, const key_type& key,
+                                       Skip_node** path[]) const
+// equal deadlines are ordered by key, so every node has one exact place
+{
+    const auto in_front = [&](const Skip_node* node) {
+        return node->deadline < deadline ||
+               (!(deadline < node->deadline) && key > node->key());
+    };
+
+    auto level = time_head.size();
+    auto next = const_cast<Skip_node**>(time_head.data());
+
+    while (level > 0) {
+        const auto index = level - 1;
+
+        if (next[index] && in_front(next[index])) {
+            next = next[index]->time_next();
+        }
+        else {
+            path[index] = next;
+            --level;
+        }
+    }
+    return next[0];
+}
+
+template <typename Key, typename T, typename Time>
+void Ttl_skip_list<Key, T, Time>::link_key(Skip_node* before[],
+                                           Skip_node* node) noexcept
+{
+    for (auto i = size_type{}; i < node->key_levels; ++i) {
+        auto& link = before[i] ? before[i]->next[i] : key_head[i];
+        const auto after = link;
+
+        node->next[i] = after;
+        node->prev()[i] = before[i];
+        if (after) {
+            after->prev()[i] = node;
+        }
+        link = node;
+    }
+}
+
+template <typename Key, typename T, typename Time>
+void Ttl_skip_list<Key, T, Time>::unlink_key(Skip_node* node) noexcept
+{
+    for (auto i = size_type{}; i < node->key_levels; ++i) {
+        const auto before = node->prev()[i];
+        const auto after = node->next[i];
+
+        (before ? before->next[i] : key_head[i]) = after;
+        if (after) {
+            after->prev()[i] = before;
+        }
+    }
+}
+
+template <typename Key, typename T, typename Time>
+void Ttl_skip_list<Key, T, Time>::link(Skip_node** path[], Skip_node* node,
+                                       Skip_node** links,
+                                       size_type levels) noexcept
+{
+    for (auto i = size_type{}; i < levels; ++i) {
+        links[i] = path[i][i];
+        path[i][i] = node;
+    }
+}
+
+template <typename Key, typename T, typename Time>
+void Ttl_skip_list<Key, T, Time>::unlink(Skip_node** path[], Skip_node** links,
+                                         size_type levels) noexcept
+// precondition: path was searched for the node, so path[i][i] is the node
+{
+    for (auto i = size_type{}; i < levels; ++i) {
+        path[i][i] = links[i];
+    }
+}
+
+template <typename Key, typename T, typename Time>
+void Ttl_skip_list<Key, T, Time>::shrink(std::vector<Skip_node*>& head) noexcept
+{
+    while (head.size() > 1 && head.back() == nullptr) {
+        head.pop_back();
+    }
+}
+
+template <typename Key, typename T, typename Time>
+typename Ttl_skip_list<Key, T, Time>::Skip_node*
+Ttl_skip_list<Key, T, Time>::allocate_node(value_type value, time_type deadline,
+                                           size_type key_levels,
+                                           size_type time_levels)
+{
+    const auto node_size =
+        sizeof(Skip_node) +
+        (2 * key_levels + time_levels - 1) * sizeof(Skip_node*);
+
+    const auto node = std::aligned_alloc(alignof(Skip_node), node_size);
+    new (node)
+        Skip_node{std::move(value), deadline, key_levels, time_levels, nullptr};
+
+    return reinterpret_cast<Skip_node*>(node);
+}
+
+template <typename Key, typename T, typename Time>
+void Ttl_skip_list<Key, T, Time>::free_node(Skip_node* node)
+{
+    node->~Skip_node();
+    std::free(node);
+}
+
+template <typename Key, typename T, typename Time>
+void Ttl_skip_list<Key, T, Time>::free_all_nodes(Skip_node* head) noexcept
+{
+    for (auto index = head; index != nullptr;) {
+        const auto temp = index;
+        index = index->next[0];
+        free_node(temp);
+    }
+}
+
+} // namespace skip_list
+#endif
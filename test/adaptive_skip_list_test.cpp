@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+
+#include "../include/adaptive_skip_list.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace skip_list;
+
+namespace {
+
+std::vector<int> zipf_trace(int key_count, int length, double exponent)
+{
+    std::vector<double> weights;
+    for (auto rank = 1; rank <= key_count; ++rank) {
+        weights.push_back(1.0 / std::pow(rank, exponent));
+    }
+
+    // scatter the ranks over the key space so hot keys are not all in front
+    std::vector<int> keys(key_count);
+    for (auto i = 0; i < key_count; ++i) {
+        keys[i] = i;
+    }
+    auto engine = std::mt19937{1};
+    std::shuffle(keys.begin(), keys.end(), engine);
+
+    auto distribution =
+        std::discrete_distribution<int>{weights.begin(), weights.end()};
+
+    std::vector<int> trace;
+    for (auto i = 0; i < length; ++i) {
+        trace.push_back(keys[distribution(engine)]);
+    }
+    return trace;
+}
+
+} // namespace
+
+TEST(Adaptive_skip_list, behaves_like_skip_list)
+{
+    Adaptive_skip_list<int, int> obj{1, 1, 4};
+
+    for (auto key = 0; key < 50; ++key) {
+        obj.insert(std::make_pair(key, key + 10));
+    }
+
+    for (auto round = 0; round < 20; ++round) {
+        for (auto key = 0; key < 50; key += 7) {
+            ASSERT_EQ(obj.find(key)->second, key + 10);
+        }
+    }
+
+    EXPECT_EQ(obj.size(), 50);
+    EXPECT_EQ(obj.erase(7), 1);
+    EXPECT_EQ(obj.find(7), obj.end());
+
+    auto key = 0;
+    for (const auto& value : obj) {
+        if (key == 7) {
+            ++key;
+        }
+        EXPECT_EQ(value.first, key++);
+    }
+}
+
+TEST(Adaptive_skip_list, zipf_trace_needs_fewer_comparisons)
+{
+    constexpr auto key_count = 1 << 14;
+
+    Adaptive_skip_list<int, int> adaptive;
+    Skip_list<int, int> plain;
+
+    for (auto key = 0; key < key_count; ++key) {
+        adaptive.insert(std::make_pair(key, key));
+        plain.insert(std::make_pair(key, key));
+    }
+
+    const auto trace = zipf_trace(key_count, 200000, 1.2);
+
+    for (const auto& key : trace) { // warm up
+        adaptive.find(key);
+    }
+
+    auto adaptive_length = 0.0;
+    auto plain_length = 0.0;
+    for (const auto& key : trace) {
+        adaptive_length += adaptive.search_length(key);
+        plain_length += plain.search_length(key);
+    }
+
+    EXPECT_LT(adaptive_length, 0.75 * plain_length);
+}
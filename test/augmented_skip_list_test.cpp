@@ -0,0 +1,127 @@
+#include "gtest/gtest.h"
+
+#include "../include/augmented_skip_list.h"
+
+#include <map>
+#include <random>
+
+using namespace skip_list;
+
+namespace {
+
+template <typename Monoid>
+int brute_force(const std::map<int, int>& reference, int lo, int hi)
+{
+    Monoid monoid;
+    auto result = monoid.identity();
+    for (auto it = reference.lower_bound(lo);
+         it != reference.end() && it->first < hi; ++it) {
+        result = monoid(result, it->second);
+    }
+    return result;
+}
+
+template <typename Monoid> void check_random_operations()
+{
+    Augmented_skip_list<int, int, Monoid> obj;
+    std::map<int, int> reference;
+
+    auto engine = std::mt19937{42};
+    auto key = std::uniform_int_distribution<int>{0, 500};
+    auto value = std::uniform_int_distribution<int>{-1000, 1000};
+
+    for (auto i = 0; i < 3000; ++i) {
+        const auto k = key(engine);
+
+        if (i % 3 == 2) {
+            EXPECT_EQ(obj.erase(k), reference.erase(k));
+        }
+        else {
+            const auto v = value(engine);
+            obj.insert(std::make_pair(k, v));
+            reference[k] = v;
+        }
+
+        if (i % 10 == 0) {
+            const auto a = key(engine);
+            const auto b = key(engine);
+            const auto lo = std::min(a, b);
+            const auto hi = std::max(a, b);
+
+            ASSERT_EQ(obj.aggregate(lo, hi),
+                      brute_force<Monoid>(reference, lo, hi));
+        }
+    }
+
+    EXPECT_EQ(obj.size(), reference.size());
+    EXPECT_EQ(obj.aggregate(), brute_force<Monoid>(reference, -1, 501));
+}
+
+} // namespace
+
+TEST(Augmented_skip_list, insert_find_erase)
+{
+    Augmented_skip_list<int, int> obj;
+
+    EXPECT_TRUE(obj.insert(std::make_pair(2, 20)).second);
+    EXPECT_TRUE(obj.insert(std::make_pair(1, 10)).second);
+    EXPECT_FALSE(obj.insert(std::make_pair(2, 25)).second);
+
+    EXPECT_EQ(obj.size(), 2);
+    EXPECT_EQ(obj.find(2)->second, 25);
+    EXPECT_EQ(obj.find(3), obj.end());
+    EXPECT_EQ(obj.begin()->first, 1);
+
+    EXPECT_EQ(obj.erase(1), 1);
+    EXPECT_EQ(obj.erase(1), 0);
+    EXPECT_EQ(obj.size(), 1);
+}
+
+TEST(Augmented_skip_list, sum)
+{
+    Augmented_skip_list<int, int> obj;
+
+    for (auto key = 1; key <= 100; ++key) {
+        obj.insert(std::make_pair(key, key));
+    }
+
+    EXPECT_EQ(obj.aggregate(), 5050);
+    EXPECT_EQ(obj.aggregate(1, 11), 55);
+    EXPECT_EQ(obj.aggregate(50, 50), 0);
+    EXPECT_EQ(obj.aggregate(100, 1000), 100);
+
+    obj.erase(5);
+    obj.insert(std::make_pair(6, 0));
+
+    EXPECT_EQ(obj.aggregate(1, 11), 44);
+}
+
+TEST(Augmented_skip_list, random_sum)
+{
+    check_random_operations<Plus<int>>();
+}
+
+TEST(Augmented_skip_list, random_min)
+{
+    check_random_operations<Minimum<int>>();
+}
+
+TEST(Augmented_skip_list, random_max)
+{
+    check_random_operations<Maximum<int>>();
+}
+
+TEST(Augmented_skip_list, copy)
+{
+    Augmented_skip_list<int, int, Maximum<int>> obj;
+
+    obj.insert(std::make_pair(1, 7));
+    obj.insert(std::make_pair(2, 3));
+
+    auto copy = obj;
+    copy.insert(std::make_pair(3, 9));
+
+    EXPECT_EQ(obj.aggregate(), 7);
+    EXPECT_EQ(copy.aggregate(), 9);
+    EXPECT_EQ(copy.aggregate(2, 3), 3);
+}
@@ -0,0 +1,82 @@
+#include "gtest/gtest.h"
+
+#include "../include/background_reclaimer.h"
+#include "../include/skip_list.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+using namespace skip_list;
+
+namespace {
+struct Counted {
+    static inline std::atomic<int> alive{0};
+    static inline std::atomic<bool> on_other_thread{false};
+    static inline std::thread::id owner;
+
+    Counted()
+    {
+        ++alive;
+    }
+    Counted(const Counted&)
+    {
+        ++alive;
+    }
+    Counted& operator=(const Counted&) = default;
+    ~Counted()
+    {
+        --alive;
+        if (std::this_thread::get_id() != owner) {
+            on_other_thread = true;
+        }
+    }
+};
+} // namespace
+
+TEST(Background_reclaimer, destroys_list_on_worker_thread)
+{
+    Counted::owner = std::this_thread::get_id();
+
+    Skip_list<int, Counted> obj;
+    for (auto key = 0; key < 10000; ++key) {
+        obj.insert(std::make_pair(key, Counted{}));
+    }
+    EXPECT_EQ(Counted::alive, 10000);
+
+    Background_reclaimer reclaimer;
+    reclaim_in_background(std::move(obj), reclaimer);
+    EXPECT_TRUE(obj.empty());
+
+    reclaimer.wait();
+    EXPECT_EQ(Counted::alive, 0);
+    EXPECT_TRUE(Counted::on_other_thread);
+}
+
+TEST(Background_reclaimer, destructor_finishes_queued_jobs)
+{
+    auto done = std::atomic<int>{0};
+
+    {
+        Background_reclaimer reclaimer;
+        for (auto i = 0; i < 100; ++i) {
+            reclaimer.post([&] { ++done; });
+        }
+    }
+
+    EXPECT_EQ(done, 100);
+}
+
+TEST(Background_reclaimer, shared_instance)
+{
+    Skip_list<int, std::string> obj;
+    for (auto key = 0; key < 1000; ++key) {
+        obj.insert(std::make_pair(key, std::to_string(key)));
+    }
+
+    reclaim_in_background(std::move(obj));
+    Background_reclaimer::instance().wait();
+
+    obj.insert(std::make_pair(1, std::string{"reused"}));
+    EXPECT_EQ(obj[1], "reused");
+}
@@ -0,0 +1,144 @@
+#include "gtest/gtest.h"
+
+#include "../include/cached_skip_list.h"
+
+#include <string>
+
+using namespace skip_list;
+
+TEST(Cached_skip_list, find_hits_after_first_lookup)
+{
+    Cached_skip_list<int, int> obj{64};
+
+    for (auto key = 0; key < 100; ++key) {
+        obj.insert(std::make_pair(key, key + 10));
+    }
+
+    EXPECT_EQ(obj.find(42)->second, 52);
+    EXPECT_EQ(obj.hits(), 0);
+    EXPECT_EQ(obj.misses(), 1);
+
+    EXPECT_EQ(obj.find(42)->second, 52);
+    EXPECT_EQ(obj.count(42), 1);
+    EXPECT_EQ(obj.hits(), 2);
+    EXPECT_EQ(obj.misses(), 1);
+    EXPECT_DOUBLE_EQ(obj.hit_rate(), 2.0 / 3.0);
+
+    EXPECT_EQ(obj.find(1000), obj.end());
+    EXPECT_EQ(obj.misses(), 2);
+}
+
+TEST(Cached_skip_list, insert_and_erase_keep_cache_consistent)
+{
+    Cached_skip_list<int, std::string> obj{16};
+
+    for (auto key = 0; key < 20; ++key) {
+        obj.insert(std::make_pair(key, std::to_string(key)));
+    }
+
+    for (auto key = 0; key < 20; ++key) {
+        obj.find(key);
+    }
+
+    // replacing values can move nodes, the cache has to follow
+    for (auto round = 0; round < 10; ++round) {
+        for (auto key = 0; key < 20; ++key) {
+            obj.insert(std::make_pair(key, std::to_string(key + round)));
+            ASSERT_EQ(obj.find(key)->second, std::to_string(key + round));
+        }
+    }
+
+    EXPECT_EQ(obj.erase(5), 1);
+    EXPECT_EQ(obj.find(5), obj.end());
+    EXPECT_EQ(obj.count(5), 0);
+
+    obj.insert(std::make_pair(5, std::string{"five"}));
+    EXPECT_EQ(obj[5], "five");
+    EXPECT_GT(obj.hits(), 0);
+
+    obj.clear();
+    EXPECT_EQ(obj.find(6), obj.end());
+}
+
+TEST(Cached_skip_list, eviction_keeps_results_correct)
+{
+    Cached_skip_list<int, int> obj{4}; // far fewer slots than keys
+
+    for (auto key = 0; key < 1000; ++key) {
+        obj.insert(std::make_pair(key, key * 2));
+    }
+
+    for (auto round = 0; round < 3; ++round) {
+        for (auto key = 0; key < 1000; key += 3) {
+            ASSERT_EQ(obj.find(key)->second, key * 2);
+            ASSERT_EQ(obj.find(key)->second, key * 2);
+        }
+    }
+    EXPECT_GT(obj.hits(), 0);
+}
+
+TEST(Cached_skip_list, moved_from_list_stays_usable)
+{
+    Cached_skip_list<int, int> obj;
+    obj.insert(std::make_pair(1, 1));
+    obj.find(1);
+
+    auto other = std::move(obj);
+    EXPECT_EQ(other.find(1)->second, 1);
+    EXPECT_EQ(other.hits(), 1); // the table moved along
+
+    EXPECT_EQ(obj.find(1), obj.end());
+    obj.insert(std::make_pair(2, 2));
+    EXPECT_EQ(obj.find(2)->second, 2);
+    EXPECT_EQ(obj.erase(2), 1);
+    EXPECT_EQ(obj.find(2), obj.end());
+
+    obj = std::move(other);
+    EXPECT_EQ(obj.find(1)->second, 1);
+    EXPECT_EQ(other.find(1), other.end());
+    other.insert(std::make_pair(3, 3));
+    EXPECT_EQ(other.find(3)->second, 3);
+}
+
+namespace {
+// counts how often two keys are compared for equality
+struct Counted_key {
+    static inline int equal_compares = 0;
+
+    int value;
+
+    bool operator==(const Counted_key& other) const
+    {
+        ++equal_compares;
+        return value == other.value;
+    }
+    bool operator>(const Counted_key& other) const
+    {
+        return value > other.value;
+    }
+};
+
+// every key starts probing at slot 0, but the hashes differ
+struct Spread_hash {
+    std::size_t operator()(const Counted_key& key) const
+    {
+        return static_cast<std::size_t>(key.value) * 4;
+    }
+};
+} // namespace
+
+TEST(Cached_skip_list, slots_compare_hashes_before_keys)
+{
+    Cached_skip_list<Counted_key, int, Spread_hash> obj{4};
+
+    for (auto key = 0; key < 4; ++key) {
+        obj.insert(std::make_pair(Counted_key{key}, key));
+        obj.find(Counted_key{key});
+    }
+
+    // key 3 is in the last slot of the window, only its node is read
+    Counted_key::equal_compares = 0;
+    EXPECT_EQ(obj.find(Counted_key{3})->second, 3);
+    EXPECT_EQ(obj.hits(), 1);
+    EXPECT_EQ(Counted_key::equal_compares, 1);
+}
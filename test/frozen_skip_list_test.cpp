@@ -0,0 +1,107 @@
+#include "gtest/gtest.h"
+
+#include "../include/frozen_skip_list.h"
+
+#include <random>
+#include <string>
+
+using namespace skip_list;
+
+TEST(Frozen_skip_list, same_lookups_as_list)
+{
+    Skip_list<int, int> list;
+
+    auto engine = std::mt19937{3};
+    auto distribution = std::uniform_int_distribution<int>{0, 20000};
+    for (auto i = 0; i < 5000; ++i) {
+        const auto key = distribution(engine);
+        list.insert(std::make_pair(key, key * 3));
+    }
+
+    const auto frozen = freeze(list);
+    ASSERT_EQ(frozen.size(), list.size());
+
+    auto it = frozen.begin();
+    for (const auto& value : list) {
+        ASSERT_EQ(it->first, value.first);
+        ASSERT_EQ(it->second, value.second);
+        ++it;
+    }
+    EXPECT_EQ(it, frozen.end());
+
+    for (auto key = -1; key <= 20001; ++key) {
+        const auto found = frozen.find(key);
+        ASSERT_EQ(found == frozen.end(), list.find(key) == list.end());
+        if (found != frozen.end()) {
+            ASSERT_EQ(found->second, key * 3);
+        }
+
+        const auto lower = frozen.lower_bound(key);
+        const auto list_lower = list.lower_bound(key);
+        ASSERT_EQ(lower == frozen.end(), list_lower == list.end());
+        if (lower != frozen.end()) {
+            ASSERT_EQ(lower->first, list_lower->first);
+        }
+
+        const auto upper = frozen.upper_bound(key);
+        const auto list_upper = list.upper_bound(key);
+        ASSERT_EQ(upper == frozen.end(), list_upper == list.end());
+        if (upper != frozen.end()) {
+            ASSERT_EQ(upper->first, list_upper->first);
+        }
+    }
+}
+
+TEST(Frozen_skip_list, sizes_of_complete_and_partial_trees)
+{
+    for (auto n = 0; n < 70; ++n) {
+        Skip_list<int, int> list;
+        for (auto key = 0; key < n; ++key) {
+            list.insert(std::make_pair(2 * key, key));
+        }
+
+        const auto frozen = freeze(list);
+        EXPECT_EQ(frozen.empty(), n == 0);
+
+        for (auto key = 0; key < n; ++key) {
+            ASSERT_EQ(frozen.find(2 * key)->second, key);
+            ASSERT_EQ(frozen.count(2 * key + 1), 0);
+            ASSERT_EQ(frozen.lower_bound(2 * key - 1)->first, 2 * key);
+        }
+        EXPECT_EQ(frozen.lower_bound(2 * n), frozen.end());
+    }
+}
+
+TEST(Frozen_skip_list, freeze_by_move_and_thaw)
+{
+    Skip_list<std::string, std::string> list;
+    for (auto key = 0; key < 300; ++key) {
+        list.insert(
+            std::make_pair("key " + std::to_string(key),
+                           std::string(40, static_cast<char>('a' + key % 26))));
+    }
+    const auto copy = list;
+
+    const auto frozen = freeze(std::move(list));
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(frozen.size(), 300);
+    EXPECT_EQ(frozen.find("key 27")->second, std::string(40, 'b'));
+
+    const auto range = frozen.equal_range("key 5");
+    EXPECT_EQ(std::distance(range.first, range.second), 1);
+
+    auto thawed = frozen.thaw();
+    EXPECT_EQ(thawed.size(), 300);
+    thawed.insert(std::make_pair(std::string{"new"}, std::string{"value"}));
+    EXPECT_EQ(thawed["new"], "value");
+
+    auto it = thawed.begin();
+    for (const auto& value : copy) {
+        if (it->first == "new") {
+            ++it;
+        }
+        ASSERT_EQ(it->first, value.first);
+        ASSERT_EQ(it->second, value.second);
+        ++it;
+    }
+}
@@ -0,0 +1,141 @@
+#include "gtest/gtest.h"
+
+#include "../include/huge_page_storage.h"
+#include "../include/skip_list.h"
+
+#include <array>
+#include <random>
+#include <string>
+
+using namespace skip_list;
+
+namespace {
+struct Test_pool;
+struct Numa_pool;
+struct Compact_pool;
+
+using Storage = Huge_page_storage<Test_pool>;
+
+template <typename T>
+using Huge_page_list = Skip_list<int, T, 0, false, Storage>;
+} // namespace
+
+TEST(Huge_page_storage, list_works_on_huge_page_chunks)
+{
+    {
+        Huge_page_list<std::string> obj;
+
+        for (auto key = 0; key < 10000; ++key) {
+            obj.insert(std::make_pair(key, std::to_string(key)));
+        }
+
+        EXPECT_EQ(obj.size(), 10000);
+        EXPECT_EQ(obj.find(4711)->second, "4711");
+
+        const auto copy = obj;
+        EXPECT_EQ(copy.find(9999)->second, "9999");
+
+        EXPECT_EQ(obj.erase(4711), 1);
+        EXPECT_EQ(obj.find(4711), obj.end());
+
+        const auto statistics = Storage::statistics();
+        EXPECT_GE(statistics.chunks, 1);
+        EXPECT_LE(statistics.huge_chunks, statistics.chunks);
+        EXPECT_GT(statistics.bytes_in_use, 0);
+    }
+
+    EXPECT_EQ(Storage::statistics().bytes_in_use, 0);
+}
+
+TEST(Huge_page_storage, freed_nodes_are_reused)
+{
+    Huge_page_list<int> obj;
+
+    for (auto key = 0; key < 1000; ++key) {
+        obj.insert(std::make_pair(key, key));
+    }
+
+    const auto chunks = Storage::statistics().chunks;
+
+    for (auto round = 0; round < 100; ++round) {
+        for (auto key = 0; key < 1000; ++key) {
+            obj.erase(key);
+        }
+        for (auto key = 0; key < 1000; ++key) {
+            obj.insert(std::make_pair(key, key + round));
+        }
+    }
+
+    EXPECT_EQ(Storage::statistics().chunks, chunks);
+    EXPECT_EQ(obj.find(999)->second, 1098);
+}
+
+TEST(Huge_page_storage, large_nodes_get_own_mapping)
+{
+    using Big = std::array<char, Storage::large_size * 2>;
+    Huge_page_list<Big> obj;
+
+    const auto before = Storage::statistics();
+    const auto chunks = before.chunks;
+
+    obj.insert(std::make_pair(1, Big{'a'}));
+    obj.insert(std::make_pair(2, Big{'b'}));
+    EXPECT_EQ(Storage::statistics().chunks, chunks + 2);
+    EXPECT_EQ(obj.find(2)->second[0], 'b');
+
+    obj.clear();
+    const auto after = Storage::statistics();
+    EXPECT_EQ(after.chunks, chunks);
+    EXPECT_EQ(after.huge_chunks, before.huge_chunks);
+    EXPECT_EQ(after.bound_chunks, before.bound_chunks);
+}
+
+TEST(Huge_page_storage, placement_applies_to_new_chunks)
+{
+    using Numa_storage = Huge_page_storage<Numa_pool>;
+
+    // node 0 exists on every machine. without NUMA support the kernel
+    // refuses mbind and the chunk keeps the default policy
+    Numa_storage::set_placement(Numa_placement{Numa_mode::interleave, 1});
+
+    Skip_list<int, int, 0, false, Numa_storage> obj;
+    for (auto key = 0; key < 100; ++key) {
+        obj.insert(std::make_pair(key, key));
+    }
+
+    const auto statistics = Numa_storage::statistics();
+    EXPECT_EQ(statistics.chunks, 1);
+    EXPECT_LE(statistics.bound_chunks, 1);
+    EXPECT_EQ(obj.find(42)->second, 42);
+}
+
+TEST(Huge_page_storage, compact_restores_locality)
+{
+    // a pool of its own, the free lists of the other tests would be reused
+    Skip_list<int, int, 0, false, Huge_page_storage<Compact_pool>> obj;
+
+    for (auto key = 0; key < 20000; ++key) {
+        obj.insert(std::make_pair(key, key));
+    }
+    EXPECT_EQ(obj.locality(), 1.0);
+
+    auto engine = std::mt19937{7};
+    auto distribution = std::uniform_int_distribution<int>{0, 19999};
+    for (auto i = 0; i < 100000; ++i) {
+        const auto key = distribution(engine);
+        obj.erase(key);
+        obj.insert(std::make_pair(key, key));
+    }
+    EXPECT_LT(obj.locality(), 0.5);
+
+    // a copy takes its nodes in key order from fresh memory as well
+    const auto copy = obj;
+    EXPECT_GT(copy.locality(), 0.99);
+
+    for (auto it = obj.begin(); it != obj.end();) {
+        it = obj.compact(it, 1000);
+    }
+    EXPECT_GT(obj.locality(), 0.99); // only a jump to the next chunk is far
+    EXPECT_EQ(obj.size(), 20000);
+    EXPECT_EQ(obj.find(12345)->second, 12345);
+}
@@ -0,0 +1,172 @@
+#include "gtest/gtest.h"
+
+#include "../include/memtable.h"
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace skip_list;
+
+namespace {
+std::uint64_t get_varint(const std::string& data, std::size_t& position)
+{
+    auto value = std::uint64_t{};
+    for (auto shift = 0;; shift += 7) {
+        const auto byte = static_cast<unsigned char>(data[position++]);
+        value |= std::uint64_t{byte & 0x7fu} << shift;
+        if (byte < 0x80) {
+            return value;
+        }
+    }
+}
+
+std::uint64_t get_fixed64(const std::string& data, std::size_t position)
+{
+    auto value = std::uint64_t{};
+    for (auto i = 0; i < 8; ++i) {
+        value |= std::uint64_t{static_cast<unsigned char>(data[position + i])}
+                 << (8 * i);
+    }
+    return value;
+}
+} // namespace
+
+TEST(Memtable, newest_version_wins_within_snapshot)
+{
+    Memtable<std::string, std::string> obj;
+
+    const auto first = obj.put("apple", "red");
+    const auto second = obj.put("apple", "green");
+    obj.put("banana", "yellow");
+    const auto removed = obj.remove("apple");
+
+    EXPECT_EQ(first, 1);
+    EXPECT_EQ(second, 2);
+    EXPECT_EQ(removed, 4);
+    EXPECT_EQ(obj.entries(), 4);
+    EXPECT_EQ(obj.last_sequence(), 4);
+
+    auto value = std::string{};
+    EXPECT_EQ(obj.get("apple", value), decltype(obj)::Lookup::deleted);
+    EXPECT_EQ(obj.get("apple", value, second), decltype(obj)::Lookup::found);
+    EXPECT_EQ(value, "green");
+    EXPECT_EQ(obj.get("apple", value, first), decltype(obj)::Lookup::found);
+    EXPECT_EQ(value, "red");
+    EXPECT_EQ(obj.get("apple", value, 0), decltype(obj)::Lookup::missing);
+    EXPECT_EQ(obj.get("banana", value), decltype(obj)::Lookup::found);
+    EXPECT_EQ(value, "yellow");
+    EXPECT_EQ(obj.get("cherry", value), decltype(obj)::Lookup::missing);
+
+    // key ascending, newest first
+    auto order = std::vector<std::pair<std::string, std::uint64_t>>{};
+    for (const auto& entry : obj) {
+        order.emplace_back(entry.first.user_key, entry.first.sequence);
+    }
+    EXPECT_EQ(order, (std::vector<std::pair<std::string, std::uint64_t>>{
+                         {"apple", 4}, {"apple", 2}, {"apple", 1},
+                         {"banana", 3}}));
+}
+
+TEST(Memtable, explicit_sequences_and_memory_usage)
+{
+    Memtable<int, std::string> obj;
+
+    obj.put(1, "one", 100);
+    obj.put(1, "uno", 50); // replayed out of order
+    EXPECT_EQ(obj.last_sequence(), 100);
+    EXPECT_EQ(obj.put(2, "two"), 101);
+
+    auto value = std::string{};
+    EXPECT_EQ(obj.get(1, value), decltype(obj)::Lookup::found);
+    EXPECT_EQ(value, "one");
+    EXPECT_EQ(obj.get(1, value, 99), decltype(obj)::Lookup::found);
+    EXPECT_EQ(value, "uno");
+
+    const auto before = obj.approximate_memory_usage();
+    EXPECT_GT(before, 3 * sizeof(decltype(obj)::value_type));
+
+    obj.put(3, std::string(1000, 'x'));
+    EXPECT_GE(obj.approximate_memory_usage(), before + 1000);
+}
+
+TEST(Memtable, flush_writes_sorted_blocks)
+{
+    Memtable<std::uint32_t, std::string> obj;
+
+    for (auto key = std::uint32_t{}; key < 1000; ++key) {
+        obj.put(999 - key, "value " + std::to_string(999 - key));
+    }
+    for (auto key = std::uint32_t{}; key < 1000; key += 10) {
+        obj.remove(key);
+    }
+
+    obj.freeze();
+    EXPECT_TRUE(obj.frozen());
+
+    auto out = std::ostringstream{};
+    const auto written = obj.flush(out, 512);
+    const auto data = out.str();
+
+    ASSERT_EQ(written, data.size());
+    ASSERT_GE(data.size(), 32);
+
+    const auto footer = data.size() - 32;
+    const auto index_offset = get_fixed64(data, footer);
+    const auto index_size = get_fixed64(data, footer + 8);
+    EXPECT_EQ(get_fixed64(data, footer + 16), 1100);
+    EXPECT_EQ(get_fixed64(data, footer + 24), decltype(obj)::run_magic);
+    EXPECT_EQ(index_offset + index_size, footer);
+
+    auto blocks = 0;
+    auto entries = 0;
+    auto tombstones = 0;
+    auto previous = std::pair<std::uint32_t, std::uint64_t>{0, 0};
+
+    for (auto position = std::size_t(index_offset); position < footer;) {
+        const auto last_key_size = get_varint(data, position);
+        position += last_key_size;
+        const auto block_offset = get_varint(data, position);
+        const auto block_size = get_varint(data, position);
+        ++blocks;
+
+        for (auto entry = std::size_t(block_offset);
+             entry < block_offset + block_size;) {
+            const auto key_size = get_varint(data, entry);
+            ASSERT_EQ(key_size, sizeof(std::uint32_t));
+
+            auto key = std::uint32_t{};
+            std::memcpy(&key, data.data() + entry, sizeof(key));
+            entry += key_size;
+
+            const auto tag = get_varint(data, entry);
+            const auto sequence = tag >> 1;
+            const auto value_size = get_varint(data, entry);
+
+            if (tag & 1) {
+                ++tombstones;
+                EXPECT_EQ(value_size, 0);
+                EXPECT_EQ(key % 10, 0);
+            }
+            else {
+                EXPECT_EQ(data.substr(entry, value_size),
+                          "value " + std::to_string(key));
+            }
+            entry += value_size;
+
+            if (entries > 0) { // key ascending, then sequence descending
+                EXPECT_TRUE(previous.first < key ||
+                            (previous.first == key &&
+                             previous.second > sequence));
+            }
+            previous = {key, sequence};
+            ++entries;
+        }
+    }
+
+    EXPECT_EQ(entries, 1100);
+    EXPECT_EQ(tombstones, 100);
+    EXPECT_GT(blocks, 10);
+}
@@ -0,0 +1,121 @@
+#include "gtest/gtest.h"
+
+#include "../include/parallel.h"
+#include "../include/skip_list.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+using namespace skip_list;
+
+TEST(Skip_list, partition_cuts_into_similar_ranges)
+{
+    Skip_list<int, int> obj;
+    EXPECT_TRUE(obj.partition(8).empty());
+
+    for (auto key = 0; key < 100000; ++key) {
+        obj.insert(std::make_pair(key, key));
+    }
+
+    const auto bounds = obj.partition(8);
+    ASSERT_EQ(bounds.size(), 9);
+    EXPECT_EQ(bounds.front(), obj.begin());
+    EXPECT_EQ(bounds.back(), obj.end());
+
+    for (auto i = std::size_t{}; i + 1 < bounds.size(); ++i) {
+        const auto length = std::distance(bounds[i], bounds[i + 1]);
+        // 12500 on average, the cuts are random but oversampled
+        EXPECT_GT(length, 3000);
+        EXPECT_LT(length, 50000);
+    }
+
+    // a short list has fewer ranges, none of them empty
+    Skip_list<int, int> short_list;
+    for (auto key = 0; key < 3; ++key) {
+        short_list.insert(std::make_pair(key, key));
+    }
+    const auto short_bounds = short_list.partition(8);
+    ASSERT_EQ(short_bounds.size(), 4);
+    for (auto i = std::size_t{}; i + 1 < short_bounds.size(); ++i) {
+        EXPECT_EQ(short_bounds[i]->first, static_cast<int>(i));
+    }
+}
+
+TEST(Parallel, for_each_visits_every_element_once)
+{
+    Thread_pool pool{3};
+    Skip_multimap<int, int> obj;
+
+    for (auto key = 0; key < 50000; ++key) {
+        obj.insert(std::make_pair(key % 1000, 0));
+    }
+
+    std::atomic<int> calls{0};
+    parallel_for_each(Parallel_policy{&pool}, obj, [&](auto& element) {
+        ++element.second;
+        ++calls;
+    });
+
+    EXPECT_EQ(calls, 50000);
+    for (const auto& element : obj) {
+        EXPECT_EQ(element.second, 1);
+    }
+}
+
+TEST(Parallel, reduce_keeps_key_order)
+{
+    Thread_pool pool{3};
+    Skip_list<int, std::string> obj;
+
+    for (auto key = 0; key < 2000; ++key) {
+        obj.insert(std::make_pair(key, std::string(1, 'a' + key % 26)));
+    }
+
+    auto expected = std::string{">"};
+    for (const auto& element : obj) {
+        expected += element.second;
+    }
+
+    // concatenation is associative but not commutative
+    const auto result = parallel_reduce(
+        Parallel_policy{&pool, 64}, obj, std::string{">"},
+        [](std::string a, const std::string& b) { return a + b; },
+        [](const auto& element) { return element.second; });
+    EXPECT_EQ(result, expected);
+
+    const auto sum = parallel_reduce(
+        Parallel_policy{}, obj, 0L, [](long a, long b) { return a + b; },
+        [](const auto& element) { return static_cast<long>(element.first); });
+    EXPECT_EQ(sum, 1999L * 2000 / 2);
+
+    Skip_list<int, std::string> empty;
+    EXPECT_EQ(parallel_reduce(
+                  Parallel_policy{&pool}, empty, 7,
+                  [](int a, int b) { return a + b; },
+                  [](const auto&) { return 1; }),
+              7);
+}
+
+TEST(Parallel, exception_of_a_range_reaches_the_caller)
+{
+    Thread_pool pool{2};
+    Skip_list<int, int> obj;
+
+    for (auto key = 0; key < 10000; ++key) {
+        obj.insert(std::make_pair(key, key));
+    }
+
+    EXPECT_THROW(parallel_for_each(Parallel_policy{&pool}, obj,
+                                   [](const auto& element) {
+                                       if (element.first == 4711) {
+                                           throw std::runtime_error{"4711"};
+                                       }
+                                   }),
+                 std::runtime_error);
+
+    // the pool is still usable afterwards
+    std::atomic<int> calls{0};
+    pool.run(100, [&](std::size_t) { ++calls; });
+    EXPECT_EQ(calls, 100);
+}
@@ -0,0 +1,228 @@
+#include "gtest/gtest.h"
+
+#include "../include/sharded_skip_list.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace skip_list;
+
+TEST(Sharded_skip_list, insert_get_erase)
+{
+    Sharded_skip_list<int, int> obj{std::vector<int>{10, 20}};
+
+    EXPECT_EQ(obj.shard_count(), 3);
+
+    obj.insert(std::make_pair(5, 50));
+    obj.insert(std::make_pair(15, 150));
+    obj.insert(std::make_pair(25, 250));
+
+    EXPECT_EQ(obj.size(), 3);
+    EXPECT_EQ(obj.get(15), 150);
+    EXPECT_EQ(obj.count(25), 1);
+    EXPECT_FALSE(obj.get(30).has_value());
+
+    EXPECT_EQ(obj.erase(15), 1);
+    EXPECT_EQ(obj.erase(15), 0);
+    EXPECT_EQ(obj.size(), 2);
+}
+
+TEST(Sharded_skip_list, for_each_is_ordered_across_shards)
+{
+    Sharded_skip_list<int, int> obj{std::vector<int>{10, 20}};
+
+    for (const auto& key : {22, 3, 17, 10, 9, 20, 1}) {
+        obj.insert(std::make_pair(key, key * 10));
+    }
+
+    std::vector<int> keys;
+    obj.for_each([&](const auto& value) { keys.push_back(value.first); });
+
+    EXPECT_EQ(keys, (std::vector<int>{1, 3, 9, 10, 17, 20, 22}));
+}
+
+TEST(Sharded_skip_list, for_each_in_range)
+{
+    Sharded_skip_list<int, int> obj{std::vector<int>{10, 20}};
+
+    for (auto key = 0; key < 30; ++key) {
+        obj.insert(std::make_pair(key, key));
+    }
+
+    std::vector<int> keys;
+    obj.for_each_in_range(
+        8, 21, [&](const auto& value) { keys.push_back(value.first); });
+
+    EXPECT_EQ(keys,
+              (std::vector<int>{8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19,
+                                20}));
+}
+
+TEST(Sharded_skip_list, rebalance_spreads_keys)
+{
+    Sharded_skip_list<int, int> obj{4};
+
+    for (auto key = 0; key < 100; ++key) {
+        obj.insert(std::make_pair(key, key));
+    }
+
+    EXPECT_TRUE(obj.rebalance());
+    EXPECT_FALSE(obj.rebalance());
+
+    EXPECT_EQ(obj.size(), 100);
+
+    std::vector<int> keys;
+    obj.for_each([&](const auto& value) { keys.push_back(value.first); });
+
+    ASSERT_EQ(keys.size(), 100);
+    for (auto key = 0; key < 100; ++key) {
+        EXPECT_EQ(keys[key], key);
+        EXPECT_EQ(obj.get(key), key);
+    }
+}
+
+TEST(Sharded_skip_list, concurrent_insert_and_rebalance)
+{
+    Sharded_skip_list<int, int> obj{8};
+
+    constexpr auto thread_count = 4;
+    constexpr auto keys_per_thread = 2000;
+
+    std::vector<std::thread> threads;
+    for (auto t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&obj, t] {
+            for (auto i = 0; i < keys_per_thread; ++i) {
+                const auto key = i * thread_count + t;
+                obj.insert(std::make_pair(key, key));
+            }
+        });
+    }
+    threads.emplace_back([&obj] {
+        for (auto i = 0; i < 20; ++i) {
+            obj.rebalance();
+            std::this_thread::yield();
+        }
+    });
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(obj.size(), thread_count * keys_per_thread);
+
+    auto previous = -1;
+    auto ordered = true;
+    obj.for_each([&](const auto& value) {
+        ordered = ordered && value.first > previous;
+        previous = value.first;
+    });
+    EXPECT_TRUE(ordered);
+}
+
+TEST(Sharded_skip_list, extract_min)
+{
+    Sharded_skip_list<int, int> obj{std::vector<int>{10, 20}};
+
+    for (const auto& key : {25, 12, 3}) {
+        obj.insert(std::make_pair(key, key * 10));
+    }
+
+    EXPECT_EQ(obj.extract_min()->first, 3);
+    EXPECT_EQ(obj.extract_min()->first, 12);
+
+    auto value = obj.extract_min(true);
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(value->first, 25);
+    EXPECT_EQ(value->second, 250);
+
+    EXPECT_FALSE(obj.extract_min().has_value());
+    EXPECT_FALSE(obj.extract_min(true).has_value());
+}
+
+TEST(Sharded_skip_list, concurrent_relaxed_extract_min)
+{
+    Sharded_skip_list<int, int> obj{std::vector<int>{250, 500, 750}};
+
+    constexpr auto key_count = 1000;
+    for (auto key = 0; key < key_count; ++key) {
+        obj.insert(std::make_pair(key, key));
+    }
+
+    std::vector<std::vector<int>> popped(4);
+    std::vector<std::thread> threads;
+    for (auto& keys : popped) {
+        threads.emplace_back([&obj, &keys] {
+            while (auto value = obj.extract_min(true)) {
+                keys.push_back(value->first);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<int> all;
+    for (const auto& keys : popped) {
+        all.insert(all.end(), keys.begin(), keys.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    ASSERT_EQ(all.size(), key_count);
+    for (auto key = 0; key < key_count; ++key) {
+        EXPECT_EQ(all[key], key);
+    }
+    EXPECT_TRUE(obj.empty());
+}
+
+TEST(Sharded_skip_list, inserts_rebalance_on_their_own)
+{
+    Sharded_skip_list<int, int> obj{4}; // everything starts in shard 0
+
+    for (auto key = 0; key < 4096; ++key) {
+        obj.insert(std::make_pair(key, key));
+    }
+
+    auto total = Sharded_skip_list<int, int>::size_type{};
+    for (auto i = std::size_t{}; i < obj.shard_count(); ++i) {
+        EXPECT_GT(obj.shard_size(i), 0);
+        EXPECT_LE(obj.shard_size(i), 2 * 4096 / 4);
+        total += obj.shard_size(i);
+    }
+    EXPECT_EQ(total, 4096);
+    EXPECT_EQ(obj.get(4095), 4095);
+
+    // erasing the upper half leaves the upper shards empty
+    for (auto key = 2048; key < 4096; ++key) {
+        obj.erase(key);
+    }
+    for (auto i = std::size_t{}; i < obj.shard_count(); ++i) {
+        EXPECT_LE(obj.shard_size(i), 2 * 2048 / 4);
+    }
+    EXPECT_EQ(obj.size(), 2048);
+
+    Sharded_skip_list<int, int> manual{4};
+    manual.set_auto_rebalance(0);
+    for (auto key = 0; key < 4096; ++key) {
+        manual.insert(std::make_pair(key, key));
+    }
+    EXPECT_EQ(manual.shard_size(0), 4096);
+}
+
+TEST(Sharded_skip_list, overwrites_do_not_count)
+{
+    Sharded_skip_list<int, int> obj{1};
+
+    for (auto round = 0; round < 10; ++round) {
+        for (auto key = 0; key < 10; ++key) {
+            obj.insert(std::make_pair(key, round));
+        }
+    }
+
+    EXPECT_EQ(obj.size(), 10);
+    EXPECT_EQ(obj.shard_size(0), 10);
+    EXPECT_EQ(obj.get(3), 9);
+
+    obj.erase(3);
+    EXPECT_EQ(obj.shard_size(0), 9);
+}
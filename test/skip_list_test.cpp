@@ -2,6 +2,8 @@
 
 #include "../include/skip_list.h"
 
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 using namespace skip_list;
@@ -572,3 +574,608 @@ TEST(Skip_list, iterator_find)
 
     EXPECT_TRUE(it == obj.end());
 }
+
+TEST(Skip_list, lower_bound)
+{
+    Skip_list<int, int> obj;
+
+    obj.insert({std::make_pair(2, 20)});
+    obj.insert({std::make_pair(4, 40)});
+    obj.insert({std::make_pair(6, 60)});
+
+    EXPECT_EQ(obj.lower_bound(1)->first, 2);
+    EXPECT_EQ(obj.lower_bound(2)->first, 2);
+    EXPECT_EQ(obj.lower_bound(3)->first, 4);
+    EXPECT_EQ(obj.lower_bound(6)->first, 6);
+    EXPECT_EQ(obj.lower_bound(7), obj.end());
+}
+
+TEST(Skip_list, find_many)
+{
+    Skip_list<int, int> obj;
+
+    for (auto key = 0; key < 100; key += 2) {
+        obj.insert(std::make_pair(key, key + 10));
+    }
+
+    std::vector<int> keys;
+    for (auto key = 101; key >= -1; --key) {
+        keys.push_back(key);
+    }
+
+    std::vector<Skip_list<int, int>::iterator> result;
+    obj.find_many(keys.begin(), keys.end(), std::back_inserter(result));
+
+    ASSERT_EQ(result.size(), keys.size());
+    for (auto i = 0u; i < keys.size(); ++i) {
+        EXPECT_EQ(result[i], obj.find(keys[i]));
+    }
+}
+
+TEST(Skip_list, pop_front)
+{
+    Skip_list<int, int> obj;
+    std::vector<int> keys{5, 3, 9, 1, 7};
+
+    for (const auto& key : keys) {
+        obj.insert(std::make_pair(key, key + 10));
+    }
+    std::sort(keys.begin(), keys.end());
+
+    for (const auto& key : keys) {
+        ASSERT_FALSE(obj.empty());
+        EXPECT_EQ(obj.begin()->first, key);
+        obj.pop_front();
+        EXPECT_EQ(obj.find(key), obj.end());
+    }
+
+    EXPECT_TRUE(obj.empty());
+    EXPECT_EQ(obj.top_level(), 1);
+}
+
+TEST(Skip_list, extract_min)
+{
+    Skip_list<int, std::string> obj;
+
+    obj.insert(std::make_pair(2, std::string{"two"}));
+    obj.insert(std::make_pair(1, std::string{"one"}));
+
+    auto value = obj.extract_min();
+
+    EXPECT_EQ(value.first, 1);
+    EXPECT_EQ(value.second, "one");
+    EXPECT_EQ(obj.size(), 1);
+    EXPECT_EQ(obj.begin()->first, 2);
+}
+
+TEST(Skip_list, extract_and_insert_node)
+{
+    Skip_list<int, std::string> hot;
+    Skip_list<int, std::string> cold;
+
+    hot.insert(std::make_pair(1, std::string{"one"}));
+    hot.insert(std::make_pair(2, std::string{"two"}));
+
+    const auto address = &*hot.find(2);
+
+    auto node = hot.extract(2);
+
+    ASSERT_FALSE(node.empty());
+    EXPECT_EQ(node.key(), 2);
+    EXPECT_EQ(node.mapped(), "two");
+    EXPECT_EQ(hot.find(2), hot.end());
+    EXPECT_TRUE(hot.extract(2).empty());
+
+    auto result = cold.insert(std::move(node));
+
+    EXPECT_TRUE(result.inserted);
+    EXPECT_TRUE(result.node.empty());
+    EXPECT_EQ(result.position->first, 2);
+    EXPECT_EQ(&*result.position, address); // same node, no reallocation
+    EXPECT_EQ(cold[2], "two");
+}
+
+TEST(Skip_list, extract_by_iterator)
+{
+    Skip_list<int, int> obj;
+
+    for (auto key = 0; key < 10; ++key) {
+        obj.insert(std::make_pair(key, key + 10));
+    }
+
+    auto first = obj.extract(obj.cbegin());
+    EXPECT_EQ(first.key(), 0);
+
+    auto middle = obj.extract(obj.find(5));
+    EXPECT_EQ(middle.key(), 5);
+    EXPECT_EQ(middle.mapped(), 15);
+
+    EXPECT_EQ(obj.size(), 8);
+}
+
+TEST(Skip_list, insert_node_key_present)
+{
+    Skip_list<int, int> obj;
+    obj.insert(std::make_pair(1, 10));
+
+    Skip_list<int, int> other;
+    other.insert(std::make_pair(1, 20));
+
+    auto result = obj.insert(other.extract(1));
+
+    EXPECT_FALSE(result.inserted);
+    ASSERT_FALSE(result.node.empty());
+    EXPECT_EQ(result.node.mapped(), 20);
+    EXPECT_EQ(result.position->second, 10);
+    EXPECT_EQ(obj.size(), 1);
+}
+
+TEST(Skip_multimap, insert_keeps_duplicates_in_insertion_order)
+{
+    Skip_multimap<int, int> obj;
+
+    for (auto value = 0; value < 50; ++value) {
+        obj.insert(std::make_pair(value % 5, value));
+    }
+
+    EXPECT_EQ(obj.size(), 50);
+
+    auto previous_key = -1;
+    auto previous_value = -1;
+    for (const auto& value : obj) {
+        if (value.first == previous_key) {
+            EXPECT_GT(value.second, previous_value);
+        }
+        else {
+            EXPECT_GT(value.first, previous_key);
+        }
+        previous_key = value.first;
+        previous_value = value.second;
+    }
+}
+
+TEST(Skip_multimap, equal_range_and_count)
+{
+    Skip_multimap<int, int> obj;
+
+    obj.insert(std::make_pair(1, 10));
+    obj.insert(std::make_pair(2, 20));
+    obj.insert(std::make_pair(2, 21));
+    obj.insert(std::make_pair(2, 22));
+    obj.insert(std::make_pair(3, 30));
+
+    EXPECT_EQ(obj.count(2), 3);
+    EXPECT_EQ(obj.count(4), 0);
+
+    auto range = obj.equal_range(2);
+    std::vector<int> values;
+    for (auto it = range.first; it != range.second; ++it) {
+        values.push_back(it->second);
+    }
+    EXPECT_EQ(values, (std::vector<int>{20, 21, 22}));
+
+    EXPECT_EQ(obj.find(2)->second, 20);
+}
+
+TEST(Skip_multimap, erase_by_key_removes_all)
+{
+    Skip_multimap<int, int> obj;
+
+    for (auto value = 0; value < 100; ++value) {
+        obj.insert(std::make_pair(value % 4, value));
+    }
+
+    EXPECT_EQ(obj.erase(2), 25);
+    EXPECT_EQ(obj.erase(2), 0);
+    EXPECT_EQ(obj.size(), 75);
+    EXPECT_EQ(obj.count(1), 25);
+    EXPECT_EQ(obj.count(3), 25);
+
+    for (const auto& value : obj) {
+        EXPECT_NE(value.first, 2);
+    }
+}
+
+TEST(Skip_multimap, erase_by_iterator_removes_one)
+{
+    Skip_multimap<int, int> obj;
+
+    for (auto value = 0; value < 20; ++value) {
+        obj.insert(std::make_pair(value % 2, value));
+    }
+
+    auto it = obj.find(1);
+    ++it;
+    ++it; // third element with key 1
+    EXPECT_EQ(it->second, 5);
+
+    auto next = obj.erase(it);
+    EXPECT_EQ(next->second, 7);
+    EXPECT_EQ(obj.count(1), 9);
+
+    std::vector<int> values;
+    auto range = obj.equal_range(1);
+    for (auto pos = range.first; pos != range.second; ++pos) {
+        values.push_back(pos->second);
+    }
+    EXPECT_EQ(values, (std::vector<int>{1, 3, 7, 9, 11, 13, 15, 17, 19}));
+}
+
+TEST(Skip_multimap, extract_and_find_many)
+{
+    Skip_multimap<int, int> obj;
+
+    for (auto value = 0; value < 30; ++value) {
+        obj.insert(std::make_pair(value % 3, value));
+    }
+
+    auto node = obj.extract(1);
+    EXPECT_EQ(node.mapped(), 1);
+    EXPECT_EQ(obj.count(1), 9);
+
+    std::vector<int> keys{0, 1, 2, 3};
+    std::vector<Skip_multimap<int, int>::iterator> result;
+    obj.find_many(keys.begin(), keys.end(), std::back_inserter(result));
+
+    EXPECT_EQ(result[0]->second, 0);
+    EXPECT_EQ(result[1]->second, 4);
+    EXPECT_EQ(result[2]->second, 2);
+    EXPECT_EQ(result[3], obj.end());
+}
+
+TEST(Skip_list, erase_by_iterator)
+{
+    Skip_list<int, int> obj;
+
+    for (auto key = 0; key < 10; ++key) {
+        obj.insert(std::make_pair(key, key + 10));
+    }
+
+    auto next = obj.erase(obj.find(4));
+
+    EXPECT_EQ(next->first, 5);
+    EXPECT_EQ(obj.find(4), obj.end());
+    EXPECT_EQ(obj.size(), 9);
+}
+
+TEST(Skip_set, types)
+{
+    EXPECT_TRUE((std::is_same_v<Skip_set<int>::key_type, int>));
+    EXPECT_TRUE((std::is_same_v<Skip_set<int>::value_type, const int>));
+    EXPECT_TRUE((std::is_void_v<Skip_set<int>::mapped_type>));
+}
+
+TEST(Skip_set, insert_find_erase)
+{
+    Skip_set<int> obj;
+    std::vector<int> keys{5, 3, 9, 1, 7, 3};
+
+    for (const auto& key : keys) {
+        obj.insert(key);
+    }
+
+    EXPECT_EQ(obj.size(), 5);
+    EXPECT_EQ(obj.count(3), 1);
+    EXPECT_EQ(*obj.find(9), 9);
+    EXPECT_EQ(obj.find(4), obj.end());
+    EXPECT_EQ(*obj.lower_bound(4), 5);
+
+    std::vector<int> ordered(obj.begin(), obj.end());
+    EXPECT_EQ(ordered, (std::vector<int>{1, 3, 5, 7, 9}));
+
+    EXPECT_EQ(obj.erase(5), 1);
+    EXPECT_EQ(obj.extract_min(), 1);
+
+    auto node = obj.extract(7);
+    EXPECT_EQ(node.key(), 7);
+
+    Skip_set<int> other;
+    other.insert(std::move(node));
+    EXPECT_EQ(other.count(7), 1);
+
+    EXPECT_EQ(obj.size(), 2);
+}
+
+TEST(Skip_set, copy)
+{
+    Skip_set<std::string> obj;
+    obj.insert(std::string{"b"});
+    obj.insert(std::string{"a"});
+
+    Skip_set<std::string> copy{obj};
+
+    std::vector<std::string> ordered(copy.begin(), copy.end());
+    EXPECT_EQ(ordered, (std::vector<std::string>{"a", "b"}));
+}
+
+TEST(Skip_list, max_level_caps_tower_height)
+{
+    Skip_list<int, int, 4> obj;
+
+    EXPECT_EQ(obj.top_level(), 1);
+
+    for (auto key = 0; key < 1000; ++key) {
+        obj.insert(std::make_pair(key, key + 10));
+    }
+
+    EXPECT_LE(obj.top_level(), 4);
+    EXPECT_EQ(obj.size(), 1000);
+    EXPECT_EQ(obj.find(500)->second, 510);
+
+    for (auto key = 0; key < 1000; key += 2) {
+        EXPECT_EQ(obj.erase(key), 1);
+    }
+
+    auto copy = obj;
+    EXPECT_EQ(copy.size(), 500);
+    EXPECT_EQ(copy.find(501)->second, 511);
+    EXPECT_EQ(copy.find(500), copy.end());
+
+    copy.clear();
+    EXPECT_TRUE(copy.empty());
+    EXPECT_EQ(copy.top_level(), 1);
+}
+
+TEST(Skip_list, max_level_head_is_inline)
+{
+    using List = Skip_list<int, int, 8>;
+
+    // the head array is part of the object, there is nothing to allocate
+    EXPECT_GE(sizeof(List), 8 * sizeof(void*));
+
+    List a;
+    a.insert(std::make_pair(1, 10));
+    List b{std::move(a)};
+
+    EXPECT_TRUE(a.empty());
+    EXPECT_EQ(b[1], 10);
+}
+
+TEST(Skip_list, set_level)
+{
+    Skip_list<int, std::string> obj;
+
+    for (auto key = 0; key < 100; ++key) {
+        obj.insert(std::make_pair(key, std::to_string(key)));
+    }
+
+    const auto top = obj.top_level();
+
+    auto it = obj.set_level(obj.find(42), top + 2);
+
+    EXPECT_EQ(obj.level(it), top + 2);
+    EXPECT_EQ(obj.top_level(), top + 2);
+    EXPECT_EQ(it->second, "42");
+    EXPECT_EQ(obj.search_length(42), 1);
+
+    it = obj.set_level(it, 1);
+    EXPECT_EQ(obj.level(it), 1);
+    EXPECT_EQ(obj.find(42)->second, "42");
+    EXPECT_EQ(obj.size(), 100);
+
+    auto key = 0;
+    for (const auto& value : obj) {
+        EXPECT_EQ(value.first, key++);
+    }
+}
+
+namespace {
+// hands out memory back to back and never reuses it, so the nodes lie in the
+// order they were allocated
+struct Arena_storage {
+    static constexpr std::size_t sequence_length = 64;
+
+    static void* allocate(std::size_t size, std::size_t alignment)
+    {
+        used = (used + alignment - 1) / alignment * alignment;
+        if (used + size > sizeof(buffer)) {
+            return nullptr;
+        }
+        const auto p = buffer + used;
+        used += size;
+        return p;
+    }
+
+    static void allocate_sequence(std::size_t count, const std::size_t* sizes,
+                                  std::size_t alignment, void** out)
+    {
+        for (auto i = std::size_t{}; i < count; ++i) {
+            out[i] = allocate(sizes[i], alignment);
+            if (out[i] == nullptr) {
+                throw std::bad_alloc{};
+            }
+        }
+    }
+
+    static void deallocate(void*, std::size_t, std::size_t) noexcept
+    {
+    }
+
+    alignas(64) static inline unsigned char buffer[1 << 20];
+    static inline std::size_t used = 0;
+};
+} // namespace
+
+TEST(Skip_list, compact_in_batches)
+{
+    Skip_list<int, std::string, 0, false, Arena_storage> obj;
+
+    for (auto key = 0; key < 1000; ++key) {
+        obj.insert(std::make_pair(key, std::to_string(key)));
+    }
+    for (auto key = 0; key < 1000; key += 3) {
+        obj.erase(key);
+        obj.insert(std::make_pair(key, std::to_string(key)));
+    }
+    // the reinserted nodes lie behind all others
+    EXPECT_LT(obj.locality(), 0.5);
+
+    auto batches = 0;
+    for (auto it = obj.begin(); it != obj.end(); ++batches) {
+        it = obj.compact(it, 64);
+    }
+    EXPECT_EQ(batches, 16);
+
+    auto key = 0;
+    for (const auto& value : obj) {
+        ASSERT_EQ(value.first, key);
+        ASSERT_EQ(value.second, std::to_string(key));
+        ++key;
+    }
+    EXPECT_EQ(key, 1000);
+    EXPECT_EQ(obj.find(999)->second, "999");
+    EXPECT_EQ(obj.locality(), 1.0);
+
+    // the returned position continues behind the batch
+    const auto it = obj.compact(obj.find(500), 10);
+    EXPECT_EQ(it->first, 510);
+    EXPECT_EQ(obj.compact(obj.end(), 10), obj.end());
+}
+
+TEST(Skip_multimap, compact_from_inside_equal_range)
+{
+    Skip_multimap<int, int> obj;
+
+    for (auto i = 0; i < 200; ++i) {
+        obj.insert(std::make_pair(i % 10, i));
+    }
+
+    auto it = std::next(obj.lower_bound(5), 7);
+    ASSERT_EQ(it->first, 5);
+    ASSERT_EQ(it->second, 75);
+
+    it = obj.compact(it, 5);
+    EXPECT_EQ(it->first, 5);
+    EXPECT_EQ(it->second, 125);
+
+    auto expected = std::vector<std::pair<int, int>>{};
+    for (auto key = 0; key < 10; ++key) {
+        for (auto value = key; value < 200; value += 10) {
+            expected.emplace_back(key, value);
+        }
+    }
+
+    auto index = std::size_t{};
+    for (const auto& value : obj) {
+        ASSERT_EQ(value.first, expected[index].first);
+        ASSERT_EQ(value.second, expected[index].second);
+        ++index;
+    }
+    EXPECT_EQ(index, expected.size());
+    EXPECT_EQ(obj.count(5), 20);
+}
+
+TEST(Skip_list, copy_large_list)
+{
+    Skip_list<int, int> trivial;
+    Skip_list<int, std::string> strings;
+
+    // more than one allocation batch
+    for (auto key = 0; key < 5000; ++key) {
+        trivial.insert(std::make_pair(key, key * 2));
+        strings.insert(std::make_pair(key, std::to_string(key)));
+    }
+
+    const auto trivial_copy = trivial;
+    const auto strings_copy = strings;
+
+    auto key = 0;
+    for (const auto& value : trivial_copy) {
+        ASSERT_EQ(value.first, key);
+        ASSERT_EQ(value.second, key * 2);
+        ++key;
+    }
+    EXPECT_EQ(key, 5000);
+    EXPECT_EQ(trivial_copy.top_level(), trivial.top_level());
+    EXPECT_EQ(trivial_copy.find(4321)->second, 8642);
+
+    key = 0;
+    for (const auto& value : strings_copy) {
+        ASSERT_EQ(value.second, std::to_string(key++));
+    }
+    EXPECT_EQ(strings_copy.find(4999)->second, "4999");
+}
+
+namespace {
+struct Throws_on_copy {
+    static inline int copies_left = 0;
+
+    Throws_on_copy() = default;
+    Throws_on_copy(const Throws_on_copy& other) : text{other.text}
+    {
+        if (copies_left-- == 0) {
+            throw std::runtime_error{"copy"};
+        }
+    }
+    Throws_on_copy& operator=(const Throws_on_copy&) = default;
+
+    std::string text = std::string(32, 'x'); // heap memory to leak
+};
+
+// asks for 1024 nodes at a time, Heap_storage only for one
+struct Batched_heap_storage : Heap_storage {
+    static constexpr std::size_t sequence_length = 1024;
+};
+
+template <typename Storage> void copy_throws_after(int copies)
+{
+    Skip_list<int, Throws_on_copy, 0, false, Storage> obj;
+
+    Throws_on_copy::copies_left = 1 << 30;
+    for (auto key = 0; key < 3000; ++key) {
+        obj.insert(std::make_pair(key, Throws_on_copy{}));
+    }
+
+    Throws_on_copy::copies_left = copies;
+    EXPECT_THROW((Skip_list<int, Throws_on_copy, 0, false, Storage>{obj}),
+                 std::runtime_error);
+}
+} // namespace
+
+TEST(Skip_list, copy_cleans_up_when_value_copy_throws)
+{
+    copy_throws_after<Heap_storage>(1500);
+    copy_throws_after<Batched_heap_storage>(1500); // in the second batch
+}
+
+TEST(Skip_list, set_level_leaves_list_unchanged_when_value_copy_throws)
+{
+    Skip_list<int, Throws_on_copy> obj;
+
+    Throws_on_copy::copies_left = 1 << 30;
+    for (auto key = 0; key < 100; ++key) {
+        obj.insert(std::make_pair(key, Throws_on_copy{}));
+    }
+
+    // the move can throw, so the value is copied into the new tower
+    const auto position = obj.find(42);
+    const auto levels = obj.level(position);
+    Throws_on_copy::copies_left = 0;
+    EXPECT_THROW(obj.set_level(position, levels + 3), std::runtime_error);
+
+    EXPECT_EQ(obj.find(42), position);
+    EXPECT_EQ(obj.level(position), levels);
+    EXPECT_EQ(position->second.text, std::string(32, 'x'));
+    EXPECT_EQ(obj.size(), 100);
+}
+
+TEST(Skip_list, compact_leaves_list_unchanged_when_value_copy_throws)
+{
+    Skip_list<int, Throws_on_copy> obj;
+
+    Throws_on_copy::copies_left = 1 << 30;
+    for (auto key = 0; key < 100; ++key) {
+        obj.insert(std::make_pair(key, Throws_on_copy{}));
+    }
+
+    // the eleventh node of the batch throws, the ten before are replaced
+    Throws_on_copy::copies_left = 10;
+    EXPECT_THROW(obj.compact(obj.begin(), 64), std::runtime_error);
+
+    auto key = 0;
+    for (const auto& value : obj) {
+        ASSERT_EQ(value.first, key++);
+        ASSERT_EQ(value.second.text, std::string(32, 'x'));
+    }
+    EXPECT_EQ(key, 100);
+}
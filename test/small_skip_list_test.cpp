@@ -0,0 +1,189 @@
+#include "gtest/gtest.h"
+
+#include "../include/small_skip_list.h"
+
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace skip_list;
+
+TEST(Small_skip_list, stays_inline_up_to_capacity)
+{
+    Small_skip_list<int, int, 4> obj;
+
+    for (const auto& key : {3, 1, 4, 2}) {
+        obj.insert(std::make_pair(key, key * 10));
+    }
+
+    EXPECT_TRUE(obj.is_small());
+    EXPECT_EQ(obj.size(), 4);
+
+    std::vector<int> keys;
+    for (const auto& value : obj) {
+        keys.push_back(value.first);
+    }
+    EXPECT_EQ(keys, (std::vector<int>{1, 2, 3, 4}));
+
+    EXPECT_EQ(obj.find(3)->second, 30);
+    EXPECT_EQ(obj.find(5), obj.end());
+    EXPECT_EQ(obj.lower_bound(0)->first, 1);
+    EXPECT_EQ(obj.lower_bound(5), obj.end());
+}
+
+TEST(Small_skip_list, promotes_and_demotes)
+{
+    Small_skip_list<int, std::string, 4> obj;
+
+    for (auto key = 0; key < 4; ++key) {
+        obj.insert(std::make_pair(key, std::to_string(key)));
+    }
+
+    // the iterator of the insert which promotes points into the tower
+    const auto promoted = obj.insert(std::make_pair(4, "4")).first;
+    EXPECT_EQ(promoted->first, 4);
+    EXPECT_EQ(std::next(promoted), obj.end());
+
+    EXPECT_FALSE(obj.is_small());
+    EXPECT_EQ(obj.size(), 5);
+    EXPECT_EQ(obj[4], "4");
+
+    obj.erase(0);
+    obj.erase(1);
+    EXPECT_FALSE(obj.is_small());
+
+    obj.erase(2);
+    EXPECT_TRUE(obj.is_small());
+    EXPECT_EQ(obj.size(), 2);
+    EXPECT_EQ(obj.begin()->second, "3");
+    EXPECT_EQ(obj[4], "4");
+}
+
+TEST(Small_skip_list, replaces_present_key)
+{
+    Small_skip_list<int, int, 2> obj;
+
+    obj.insert(std::make_pair(1, 10));
+    obj.insert(std::make_pair(1, 11));
+    EXPECT_EQ(obj.size(), 1);
+    EXPECT_EQ(obj[1], 11);
+
+    obj.insert(std::make_pair(2, 20));
+    obj.insert(std::make_pair(3, 30));
+    obj.insert(std::make_pair(3, 31));
+    EXPECT_EQ(obj.size(), 3);
+    EXPECT_EQ(obj[3], 31);
+}
+
+TEST(Small_skip_list, random_operations)
+{
+    Small_skip_list<int, int, 8> obj;
+    std::map<int, int> reference;
+
+    auto engine = std::mt19937{7};
+    auto key = std::uniform_int_distribution<int>{0, 20};
+
+    for (auto i = 0; i < 2000; ++i) {
+        const auto k = key(engine);
+
+        if (i % 2) {
+            ASSERT_EQ(obj.erase(k), reference.erase(k));
+        }
+        else {
+            obj.insert(std::make_pair(k, i));
+            reference[k] = i;
+        }
+
+        ASSERT_EQ(obj.size(), reference.size());
+        ASSERT_TRUE(std::equal(obj.begin(), obj.end(), reference.begin(),
+                               reference.end()));
+    }
+}
+
+TEST(Small_skip_list, copy_and_move)
+{
+    Small_skip_list<int, std::string, 2> small;
+    small.insert(std::make_pair(1, std::string{"one"}));
+
+    Small_skip_list<int, std::string, 2> large;
+    for (auto key = 0; key < 10; ++key) {
+        large.insert(std::make_pair(key, std::to_string(key)));
+    }
+
+    auto small_copy = small;
+    auto large_copy = large;
+    EXPECT_EQ(small_copy[1], "one");
+    EXPECT_EQ(large_copy.size(), 10);
+
+    auto moved = std::move(large_copy);
+    EXPECT_EQ(moved.size(), 10);
+    EXPECT_TRUE(large_copy.empty());
+
+    moved = small;
+    EXPECT_TRUE(moved.is_small());
+    EXPECT_EQ(moved[1], "one");
+}
+
+namespace {
+// moves without throwing, copies throw once copies_left runs out
+struct Throws_on_copy {
+    static inline int copies_left = 0;
+
+    Throws_on_copy() = default;
+    Throws_on_copy(const Throws_on_copy& other) : text{other.text}
+    {
+        if (copies_left-- == 0) {
+            throw std::runtime_error{"copy"};
+        }
+    }
+    Throws_on_copy(Throws_on_copy&&) noexcept = default;
+    Throws_on_copy& operator=(const Throws_on_copy&) = default;
+
+    std::string text = std::string(32, 'x'); // heap memory to leak
+};
+} // namespace
+
+TEST(Small_skip_list, throwing_copies_leave_it_consistent)
+{
+    Small_skip_list<int, Throws_on_copy, 8> obj;
+
+    Throws_on_copy::copies_left = 1 << 30;
+    for (auto key = 0; key < 8; key += 2) {
+        obj.insert(std::make_pair(key, Throws_on_copy{}));
+    }
+
+    // in front of the others, the copy is made before they are shifted
+    Throws_on_copy::copies_left = 0;
+    EXPECT_THROW(obj.insert(std::make_pair(1, Throws_on_copy{})),
+                 std::runtime_error);
+    EXPECT_TRUE(obj.is_small());
+    EXPECT_EQ(obj.size(), 4);
+    EXPECT_EQ(obj.count(1), 0);
+    EXPECT_EQ(obj.find(6)->second.text, std::string(32, 'x'));
+
+    // the slots copied before the throw are destroyed again
+    Throws_on_copy::copies_left = 2;
+    EXPECT_THROW((Small_skip_list<int, Throws_on_copy, 8>{obj}),
+                 std::runtime_error);
+}
+
+TEST(Small_skip_list, keys_with_throwing_copies_stay_in_the_list)
+{
+    Small_skip_list<std::string, int, 4> obj;
+    EXPECT_TRUE(obj.is_small());
+
+    obj.insert(std::make_pair(std::string{"b"}, 2));
+    obj.insert(std::make_pair(std::string{"a"}, 1));
+    EXPECT_FALSE(obj.is_small());
+    EXPECT_EQ(obj.begin()->first, "a");
+
+    obj.erase("b");
+    EXPECT_FALSE(obj.is_small());
+    EXPECT_EQ(obj.size(), 1);
+
+    auto moved = std::move(obj);
+    EXPECT_EQ(moved["a"], 1);
+    EXPECT_TRUE(obj.empty());
+}
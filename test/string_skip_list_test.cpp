@@ -0,0 +1,183 @@
+#include "gtest/gtest.h"
+
+#include "../include/string_skip_list.h"
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace skip_list;
+
+namespace {
+std::string path_key(int value)
+// long shared prefixes like file paths or URLs
+{
+    return "/srv/data/warehouse/partitions/" + std::to_string(value % 7) +
+           "/segment_" + std::to_string(value);
+}
+} // namespace
+
+TEST(String_skip_list, behaves_like_map_with_shared_prefixes)
+{
+    String_skip_list<int> obj;
+    std::map<std::string, int> reference;
+
+    auto engine = std::mt19937{42};
+    auto distribution = std::uniform_int_distribution<int>{0, 999};
+
+    for (auto i = 0; i < 3000; ++i) {
+        const auto value = distribution(engine);
+        const auto key = path_key(value);
+
+        if (i % 3 == 2) {
+            EXPECT_EQ(obj.erase(key), reference.erase(key));
+        }
+        else {
+            obj.insert(std::make_pair(std::string_view{key}, value));
+            reference[key] = value;
+        }
+    }
+
+    ASSERT_EQ(obj.size(), reference.size());
+
+    auto it = obj.begin();
+    for (const auto& [key, value] : reference) {
+        ASSERT_EQ(it->first, key);
+        ASSERT_EQ(it->second, value);
+        ++it;
+    }
+    EXPECT_EQ(it, obj.end());
+
+    for (auto value = 0; value < 1000; ++value) {
+        const auto key = path_key(value);
+        const auto found = obj.find(key);
+        const auto expected = reference.find(key);
+
+        if (expected == reference.end()) {
+            EXPECT_EQ(found, obj.end());
+            EXPECT_EQ(obj.count(key), 0);
+        }
+        else {
+            ASSERT_NE(found, obj.end());
+            EXPECT_EQ(found->second, expected->second);
+        }
+
+        const auto lower = obj.lower_bound(key);
+        const auto expected_lower = reference.lower_bound(key);
+        if (expected_lower == reference.end()) {
+            EXPECT_EQ(lower, obj.end());
+        }
+        else {
+            EXPECT_EQ(lower->first, expected_lower->first);
+        }
+    }
+}
+
+TEST(String_skip_list, keys_are_copied_into_the_arena)
+{
+    String_skip_list<int> obj;
+
+    {
+        auto key = std::string{"a key which is too long for the short string"};
+        obj.insert(std::make_pair(std::string_view{key}, 1));
+        key.assign(key.size(), 'x'); // the list must not see this
+    }
+
+    const auto it = obj.begin();
+    EXPECT_EQ(it->first, "a key which is too long for the short string");
+    EXPECT_EQ(obj["a key which is too long for the short string"], 1);
+
+    const auto huge = std::string(100000, 'h');
+    obj.insert(std::make_pair(std::string_view{huge}, 2));
+    EXPECT_EQ(obj[huge], 2);
+    EXPECT_EQ(obj.dead_bytes(), 0);
+    EXPECT_GE(obj.arena_bytes(), huge.size() + 44);
+
+    EXPECT_EQ(obj.erase(huge), 1);
+    EXPECT_EQ(obj.size(), 1);
+    EXPECT_EQ(obj.dead_bytes(), huge.size());
+
+    // a copy only interns the keys still present
+    const auto copy = obj;
+    EXPECT_EQ(copy.size(), 1);
+    EXPECT_LT(copy.arena_bytes(), obj.arena_bytes());
+    EXPECT_EQ(copy.begin()->first, obj.begin()->first);
+    EXPECT_NE(copy.begin()->first.data(), obj.begin()->first.data());
+}
+
+TEST(String_skip_list, handles_prefixes_and_empty_key)
+{
+    String_skip_list<int> obj;
+    const auto keys = std::vector<std::string>{"abc", "", "ab", "abcd", "b",
+                                               "abd", "a", "\xff", "ab\x80"};
+
+    for (auto i = 0; i < static_cast<int>(keys.size()); ++i) {
+        obj.insert(std::make_pair(std::string_view{keys[i]}, i));
+    }
+
+    auto expected = std::map<std::string, int>{};
+    for (auto i = 0; i < static_cast<int>(keys.size()); ++i) {
+        expected[keys[i]] = i;
+    }
+
+    auto it = obj.begin();
+    for (const auto& [key, value] : expected) {
+        ASSERT_EQ(it->first, key);
+        EXPECT_EQ(it->second, value);
+        ++it;
+    }
+
+    EXPECT_EQ(obj.lower_bound("abca")->first, "abcd");
+    EXPECT_EQ(obj.lower_bound("ab\x7f")->first, "ab\x80");
+    EXPECT_EQ(obj.find("abce"), obj.end());
+    EXPECT_EQ(obj[""], 1);
+
+    obj.clear();
+    EXPECT_TRUE(obj.empty());
+    EXPECT_EQ(obj.arena_bytes(), 0);
+}
+
+TEST(String_skip_list, moved_from_arena_interns_again)
+{
+    Key_arena arena;
+    const auto kept = arena.intern("kept");
+
+    auto other = std::move(arena);
+    EXPECT_EQ(other.interned_bytes(), 4);
+    EXPECT_EQ(kept, "kept"); // the block moved along
+
+    EXPECT_EQ(arena.bytes(), 0);
+    EXPECT_EQ(arena.intern("again"), "again");
+    EXPECT_EQ(arena.interned_bytes(), 5);
+
+    arena = std::move(other);
+    EXPECT_EQ(arena.interned_bytes(), 4);
+    EXPECT_EQ(other.intern("third"), "third");
+}
+
+TEST(String_skip_list, arena_stays_bounded_under_churn)
+{
+    String_skip_list<int> obj;
+
+    for (auto key = 0; key < 1000; ++key) {
+        obj.insert(std::make_pair(path_key(key), key));
+    }
+    const auto live_bytes = obj.arena_bytes();
+
+    // a window of 1000 keys slides over 50000, without reuse the arena would
+    // grow 50 fold
+    for (auto key = 1000; key < 50000; ++key) {
+        ASSERT_EQ(obj.erase(path_key(key - 1000)), 1);
+        obj.insert(std::make_pair(path_key(key), key));
+    }
+    EXPECT_EQ(obj.size(), 1000);
+    EXPECT_LT(obj.arena_bytes(), 4 * live_bytes);
+    EXPECT_EQ(obj.find(path_key(48999)), obj.end());
+    EXPECT_EQ(obj.find(path_key(49000))->second, 49000);
+
+    obj.shrink();
+    EXPECT_EQ(obj.dead_bytes(), 0);
+    EXPECT_LE(obj.arena_bytes(), live_bytes);
+    EXPECT_EQ(obj.find(path_key(49999))->second, 49999);
+}
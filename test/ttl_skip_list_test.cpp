@@ -0,0 +1,160 @@
+#include "gtest/gtest.h"
+
+#include "../include/ttl_skip_list.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace skip_list;
+
+namespace {
+// plain numbers as deadlines keep the tests independent of the clock
+using Ttl_list = Ttl_skip_list<int, std::string, int>;
+} // namespace
+
+TEST(Ttl_skip_list, expires_in_deadline_order_within_budget)
+{
+    Ttl_list obj;
+
+    for (auto key = 0; key < 100; ++key) {
+        // deadlines in a different order than the keys, with ties
+        obj.insert(std::make_pair(key, std::to_string(key)), (key * 37) % 50);
+    }
+    EXPECT_EQ(obj.size(), 100);
+    EXPECT_EQ(*obj.next_deadline(), 0);
+
+    auto expired = std::vector<std::pair<int, int>>{};
+    const auto collect = [&](Ttl_list::value_type& value, int deadline) {
+        expired.emplace_back(deadline, value.first);
+    };
+
+    EXPECT_EQ(obj.expire_until(9, 5, collect), 5);
+    EXPECT_EQ(obj.expire_until(9, 100, collect), 15);
+    EXPECT_EQ(obj.expire_until(9, 100, collect), 0);
+
+    EXPECT_TRUE(std::is_sorted(expired.begin(), expired.end()));
+    for (const auto& [deadline, key] : expired) {
+        EXPECT_LE(deadline, 9);
+        EXPECT_EQ(obj.find(key), obj.end());
+    }
+
+    EXPECT_EQ(obj.size(), 80);
+    EXPECT_EQ(*obj.next_deadline(), 10);
+
+    auto previous = -1;
+    for (const auto& [key, value] : obj) {
+        EXPECT_GT(key, previous);
+        EXPECT_EQ(value, std::to_string(key));
+        EXPECT_GT(obj.deadline(obj.find(key)), 9);
+        previous = key;
+    }
+
+    EXPECT_EQ(obj.expire_until(49, 1000), 80);
+    EXPECT_TRUE(obj.empty());
+    EXPECT_FALSE(obj.next_deadline());
+}
+
+TEST(Ttl_skip_list, insert_of_present_key_moves_deadline)
+{
+    Ttl_list obj;
+
+    EXPECT_TRUE(obj.insert(std::make_pair(1, "a"), 10).second);
+    EXPECT_TRUE(obj.insert(std::make_pair(2, "b"), 20).second);
+
+    const auto [position, inserted] = obj.insert(std::make_pair(1, "c"), 30);
+    EXPECT_FALSE(inserted);
+    EXPECT_EQ(position->second, "c");
+    EXPECT_EQ(obj.deadline(position), 30);
+    EXPECT_EQ(obj.size(), 2);
+
+    EXPECT_EQ(obj.expire_until(25, 10), 1);
+    EXPECT_EQ(obj.find(2), obj.end());
+    EXPECT_EQ(obj.find(1)->second, "c");
+
+    EXPECT_TRUE(obj.set_deadline(1, 5));
+    EXPECT_FALSE(obj.set_deadline(2, 5));
+    EXPECT_EQ(obj.expire_until(5, 10), 1);
+    EXPECT_TRUE(obj.empty());
+}
+
+TEST(Ttl_skip_list, behaves_like_two_maps)
+{
+    Ttl_list obj;
+    std::map<int, std::pair<std::string, int>> reference;
+
+    auto engine = std::mt19937{11};
+    auto key_distribution = std::uniform_int_distribution<int>{0, 499};
+    auto time_distribution = std::uniform_int_distribution<int>{0, 99};
+
+    for (auto now = 0; now < 100; ++now) {
+        for (auto i = 0; i < 30; ++i) {
+            const auto key = key_distribution(engine);
+            const auto deadline = now + time_distribution(engine);
+
+            if (i % 5 == 0) {
+                EXPECT_EQ(obj.erase(key), reference.erase(key));
+            }
+            else {
+                obj.insert(std::make_pair(key, std::to_string(i)), deadline);
+                reference[key] = std::make_pair(std::to_string(i), deadline);
+            }
+        }
+
+        const auto expired = obj.expire_until(
+            now, 10, [&](Ttl_list::value_type& value, int deadline) {
+                EXPECT_LE(deadline, now);
+                EXPECT_EQ(reference[value.first].second, deadline);
+                reference.erase(value.first);
+            });
+        EXPECT_LE(expired, 10);
+
+        ASSERT_EQ(obj.size(), reference.size());
+    }
+
+    auto it = obj.begin();
+    for (const auto& [key, entry] : reference) {
+        ASSERT_NE(it, obj.end());
+        EXPECT_EQ(it->first, key);
+        EXPECT_EQ(it->second, entry.first);
+        EXPECT_EQ(obj.deadline(it), entry.second);
+        ++it;
+    }
+
+    const auto copy = obj;
+    EXPECT_EQ(copy.size(), obj.size());
+    obj.clear();
+    EXPECT_TRUE(obj.empty());
+    EXPECT_EQ(obj.expire_until(1000, 100000), 0);
+}
+
+TEST(Ttl_skip_list, throwing_callback_leaves_list_consistent)
+{
+    Ttl_list obj;
+
+    for (auto key = 0; key < 10; ++key) {
+        obj.insert(std::make_pair(key, std::to_string(key)), key);
+    }
+
+    auto seen = std::string{};
+    EXPECT_THROW(obj.expire_until(9, 10,
+                                  [&](Ttl_list::value_type& value, int) {
+                                      seen = std::move(value.second);
+                                      if (value.first == 2) {
+                                          throw std::runtime_error{"2"};
+                                      }
+                                  }),
+                 std::runtime_error);
+
+    // the entry which threw is gone with the ones before it
+    EXPECT_EQ(seen, "2");
+    EXPECT_EQ(obj.size(), 7);
+    EXPECT_EQ(obj.begin()->first, 3);
+    EXPECT_EQ(*obj.next_deadline(), 3);
+
+    EXPECT_EQ(obj.expire_until(9, 10), 7);
+    EXPECT_TRUE(obj.empty());
+}